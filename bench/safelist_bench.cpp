@@ -0,0 +1,492 @@
+/***************************************************************************
+                          safelist_bench.cpp  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+/*
+    SafeList benchmarks
+
+    Stand-alone benchmark driver with no dependencies beyond the headers in
+    this repository. Build it the same way as anything else that includes
+    safelist.h, for example:
+
+        g++ -std=c++11 -O2 -pthread -I.. safelist_bench.cpp -o safelist_bench
+
+    and run it with:
+
+        ./safelist_bench [--quick] [--filter text] [--save file]
+                         [--baseline file] [--tolerance 0.10]
+
+    Each result is printed as "name value unit". --save writes the results
+    to a file; --baseline compares against a saved file and exits with
+    status 1 if any result is worse than the baseline by more than the
+    tolerance (10% by default), so a build step can fail on a regression.
+
+    Scenarios:
+        throughput/<backend>/<P>p<C>c   items per second, P producers and C consumers
+        latency/<backend>/p50|p99|p999  push to pop latency in ns, 1 producer 1 consumer
+        visit_all/<size>                ns per item visited, locked and snapshot
+        remove/<size>                   ns per remove(value), erase(handle), IndexedSafeList
+        batch/<op>                      ns per item for single and batched push/pop
+
+    Every backend is driven through the same push_back()/try_pop() calls, so
+    lock policies, allocators and storage classes can be compared directly.
+*/
+
+#include "safelist.h"
+#include "shardedsafelist.h"
+#include "saferinglist.h"
+#include "indexedsafelist.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+
+struct Options
+{
+    Options() : quick(false), tolerance(0.10) {}
+
+    bool quick;
+    string filter;
+    string save_path;
+    string baseline_path;
+    double tolerance;
+};
+
+struct Result
+{
+    string name;
+    double value;
+    string unit;
+    bool higher_is_better;
+};
+
+Options options;
+vector<Result> results;
+
+unsigned long long NowNs()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool Wanted(const string& name)
+{
+    return options.filter.empty() || name.find(options.filter) != string::npos;
+}
+
+void Report(const string& name, double value, const string& unit, bool higher_is_better)
+{
+    Result result;
+    result.name = name;
+    result.value = value;
+    result.unit = unit;
+    result.higher_is_better = higher_is_better;
+    results.push_back(result);
+    printf("%-48s %14.1f %s\n", name.c_str(), value, unit.c_str());
+    fflush(stdout);
+}
+
+/*
+    Throughput
+
+    Producers push items_per_producer items each; consumers pop until the
+    producers are done and a final try_pop() comes back empty.
+*/
+template <class Queue>
+double Throughput(Queue& queue, int producers, int consumers, long items_per_producer)
+{
+    atomic<bool> go(false);
+    atomic<bool> producers_done(false);
+    atomic<long> consumed(0);
+    vector<thread> producer_threads;
+    vector<thread> consumer_threads;
+
+    for (int p = 0; p < producers; ++p)
+    {
+        producer_threads.push_back(thread([&]()
+        {
+            while (!go.load(memory_order_acquire))
+                this_thread::yield();
+            for (long i = 1; i <= items_per_producer; ++i)
+                queue.push_back(i);
+        }));
+    }
+    for (int c = 0; c < consumers; ++c)
+    {
+        consumer_threads.push_back(thread([&]()
+        {
+            long item;
+            long local = 0;
+            while (!go.load(memory_order_acquire))
+                this_thread::yield();
+            for (;;)
+            {
+                if (queue.try_pop(item))
+                {
+                    ++local;
+                    continue;
+                }
+                if (producers_done.load(memory_order_acquire))
+                {
+                    if (!queue.try_pop(item))
+                        break;
+                    ++local;
+                    continue;
+                }
+                this_thread::yield();
+            }
+            consumed.fetch_add(local);
+        }));
+    }
+
+    unsigned long long start = NowNs();
+    go.store(true, memory_order_release);
+    for (size_t i = 0; i < producer_threads.size(); ++i)
+        producer_threads[i].join();
+    producers_done.store(true, memory_order_release);
+    for (size_t i = 0; i < consumer_threads.size(); ++i)
+        consumer_threads[i].join();
+    unsigned long long elapsed = NowNs() - start;
+
+    if (consumed.load() != producers * items_per_producer)
+    {
+        fprintf(stderr, "lost items: consumed %ld of %ld\n", consumed.load(), producers * items_per_producer);
+        exit(2);
+    }
+    return (double)consumed.load() * 1e9 / (double)(elapsed ? elapsed : 1);
+}
+
+template <class Queue>
+void ThroughputSuite(const string& backend)
+{
+    static const int shapes[][2] = { {1, 1}, {4, 1}, {1, 4}, {4, 4} };
+    long items = options.quick ? 20000 : 500000;
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "throughput/%s/%dp%dc", backend.c_str(), shapes[i][0], shapes[i][1]);
+        if (!Wanted(name))
+            continue;
+        Queue queue;
+        Report(name, Throughput(queue, shapes[i][0], shapes[i][1], items / shapes[i][0]), "items/s", true);
+    }
+}
+
+/*
+    Latency
+
+    The producer stamps each item with its enqueue time and paces itself so
+    the queue stays short; the consumer spins on try_pop() and records how
+    long each item sat in the queue.
+*/
+template <class Queue>
+void LatencySuite(const string& backend)
+{
+    string prefix = "latency/" + backend + "/";
+    if (!Wanted(prefix))
+        return;
+
+    long samples = options.quick ? 20000 : 200000;
+    Queue queue;
+    vector<unsigned long long> latencies;
+    latencies.reserve(samples);
+
+    thread consumer([&]()
+    {
+        long stamp;
+        while ((long)latencies.size() < samples)
+        {
+            if (queue.try_pop(stamp))
+                latencies.push_back(NowNs() - (unsigned long long)stamp);
+        }
+    });
+    for (long i = 0; i < samples; ++i)
+    {
+        queue.push_back((long)NowNs());
+        for (int spin = 0; spin < 200; ++spin)
+            SafeListCpuRelax();
+    }
+    consumer.join();
+
+    sort(latencies.begin(), latencies.end());
+    Report(prefix + "p50", (double)latencies[latencies.size() / 2], "ns", false);
+    Report(prefix + "p99", (double)latencies[latencies.size() * 99 / 100], "ns", false);
+    Report(prefix + "p999", (double)latencies[latencies.size() * 999 / 1000], "ns", false);
+}
+
+void VisitSuite()
+{
+    size_t max_size = options.quick ? 100000 : 1000000;
+    for (size_t size = 1000; size <= max_size; size *= 10)
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "visit_all/%zu", size);
+        if (!Wanted(name))
+            continue;
+
+        SafeList<long, SafeListTraits<AdaptiveMutexLock, SafeListWithSnapshotCache> > list;
+        for (size_t i = 0; i < size; ++i)
+            list.push_back((long)i);
+
+        long sum = 0;
+        unsigned long long start = NowNs();
+        list.visit_all([&](const long& item) { sum += item; return true; });
+        Report(name, (double)(NowNs() - start) / size, "ns/item", false);
+
+        string snapshot_name = string(name) + "/snapshot";
+        start = NowNs();
+        list.visit_snapshot([&](const long& item) { sum += item; return true; });
+        Report(snapshot_name, (double)(NowNs() - start) / size, "ns/item", false);
+
+        start = NowNs();
+        list.visit_snapshot([&](const long& item) { sum += item; return true; });
+        Report(snapshot_name + "_cached", (double)(NowNs() - start) / size, "ns/item", false);
+
+        if (sum == 42)
+            printf("\n");
+    }
+}
+
+void RemoveSuite()
+{
+    size_t max_size = options.quick ? 10000 : 100000;
+    size_t removals = 100;
+    for (size_t size = 1000; size <= max_size; size *= 10)
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "remove/%zu", size);
+        if (!Wanted(name))
+            continue;
+
+        SafeList<long, SafeListTraits<AdaptiveMutexLock, SafeListWithHandles> > list;
+        vector<SafeListHandle> handles;
+        IndexedSafeList<long> indexed;
+        for (size_t i = 0; i < size; ++i)
+        {
+            handles.push_back(list.push_back_handle((long)i));
+            indexed.push_back((long)i);
+        }
+
+        /* Remove from the middle outwards so remove() pays a realistic scan. */
+        unsigned long long start = NowNs();
+        for (size_t i = 0; i < removals; ++i)
+            list.remove((long)(size / 2 + i));
+        Report(string(name) + "/value", (double)(NowNs() - start) / removals, "ns/op", false);
+
+        start = NowNs();
+        for (size_t i = 0; i < removals; ++i)
+            list.erase(handles[size / 4 + i]);
+        Report(string(name) + "/handle", (double)(NowNs() - start) / removals, "ns/op", false);
+
+        start = NowNs();
+        for (size_t i = 0; i < removals; ++i)
+            indexed.remove((long)(size / 2 + i));
+        Report(string(name) + "/indexed", (double)(NowNs() - start) / removals, "ns/op", false);
+    }
+}
+
+void BatchSuite()
+{
+    const size_t burst = 512;
+    size_t bursts = options.quick ? 200 : 2000;
+    vector<long> items(burst, 1);
+    vector<long> out;
+    out.reserve(burst);
+    SafeList<long> list;
+
+    if (Wanted("batch/push_single"))
+    {
+        unsigned long long start = NowNs();
+        for (size_t b = 0; b < bursts; ++b)
+        {
+            for (size_t i = 0; i < burst; ++i)
+                list.push_back(items[i]);
+            long item;
+            while (list.try_pop(item))
+                ;
+        }
+        Report("batch/push_single", (double)(NowNs() - start) / (bursts * burst), "ns/item", false);
+    }
+
+    if (Wanted("batch/push_range"))
+    {
+        unsigned long long start = NowNs();
+        for (size_t b = 0; b < bursts; ++b)
+        {
+            list.push_back(items.begin(), items.end());
+            out.clear();
+            list.pop_front_n(back_inserter(out), burst);
+        }
+        Report("batch/push_range", (double)(NowNs() - start) / (bursts * burst), "ns/item", false);
+    }
+}
+
+bool LoadBaseline(const string& path, map<string, double>& baseline)
+{
+    ifstream in(path.c_str());
+    if (!in)
+        return false;
+    string name;
+    double value;
+    string unit;
+    while (in >> name >> value >> unit)
+        baseline[name] = value;
+    return true;
+}
+
+int CompareWithBaseline()
+{
+    map<string, double> baseline;
+    if (!LoadBaseline(options.baseline_path, baseline))
+    {
+        fprintf(stderr, "can't read baseline %s\n", options.baseline_path.c_str());
+        return 2;
+    }
+
+    int regressions = 0;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        map<string, double>::const_iterator old = baseline.find(results[i].name);
+        if (old == baseline.end() || old->second <= 0)
+            continue;
+        double change = results[i].higher_is_better ? old->second / results[i].value - 1.0
+                                                    : results[i].value / old->second - 1.0;
+        if (change > options.tolerance)
+        {
+            fprintf(stderr, "REGRESSION %s: %.1f -> %.1f %s (%.0f%% worse)\n", results[i].name.c_str(),
+                    old->second, results[i].value, results[i].unit.c_str(), change * 100.0);
+            ++regressions;
+        }
+    }
+    return regressions ? 1 : 0;
+}
+
+void SaveResults()
+{
+    ofstream out(options.save_path.c_str());
+    for (size_t i = 0; i < results.size(); ++i)
+        out << results[i].name << " " << results[i].value << " " << results[i].unit << "\n";
+}
+
+bool ParseArgs(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--quick")
+            options.quick = true;
+        else if (arg == "--filter" && i + 1 < argc)
+            options.filter = argv[++i];
+        else if (arg == "--save" && i + 1 < argc)
+            options.save_path = argv[++i];
+        else if (arg == "--baseline" && i + 1 < argc)
+            options.baseline_path = argv[++i];
+        else if (arg == "--tolerance" && i + 1 < argc)
+            options.tolerance = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [--quick] [--filter text] [--save file] [--baseline file] [--tolerance fraction]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef SafeList<long, AdaptiveMutexLock> AdaptiveList;
+typedef SafeList<long, std::mutex> StdMutexList;
+typedef SafeList<long, TicketSpinLock> TicketList;
+typedef SafeList<long, RecursiveMutexLock> RecursiveList;
+typedef SafeList<long, WriterPreferringSharedMutexLock> SharedList;
+typedef SafeList<long, AdaptiveMutexLock, NodePoolAllocator<long> > PooledList;
+typedef SafeList<long, LockFreePolicy> LockFreeList;
+typedef SafeRingList<long> RingList;
+typedef ShardedSafeList<long> ShardedList;
+
+}
+
+int main(int argc, char** argv)
+{
+    if (!ParseArgs(argc, argv))
+        return 2;
+
+    ThroughputSuite<AdaptiveList>("adaptive");
+    ThroughputSuite<StdMutexList>("std_mutex");
+    ThroughputSuite<TicketList>("ticket");
+    ThroughputSuite<RecursiveList>("recursive");
+    ThroughputSuite<SharedList>("shared");
+    ThroughputSuite<PooledList>("pooled");
+    ThroughputSuite<LockFreeList>("lockfree");
+    ThroughputSuite<RingList>("ring");
+    ThroughputSuite<ShardedList>("sharded");
+
+    LatencySuite<AdaptiveList>("adaptive");
+    LatencySuite<LockFreeList>("lockfree");
+    LatencySuite<RingList>("ring");
+
+    VisitSuite();
+    RemoveSuite();
+    BatchSuite();
+
+    if (!options.save_path.empty())
+        SaveResults();
+    if (!options.baseline_path.empty())
+        return CompareWithBaseline();
+    return 0;
+}
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,199 @@
+/***************************************************************************
+                          indexedsafelist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef INDEXEDSAFELIST_H
+#define INDEXEDSAFELIST_H
+
+#include "safelist.h"
+#include <unordered_map>
+
+using namespace std;
+
+/*
+    IndexedSafeList
+
+    A SafeList with a companion hash index from value to node, so that
+    remove(arg) and contains(arg) cost O(number of equal items) instead of a
+    scan of the whole list. Everything else behaves like SafeList.
+
+    The index holds a copy of every value, so this is meant for small keys
+    such as pointers or ids; T must be copyable and hashable with Hash. Only
+    the operations below keep the index up to date, which is why SafeList
+    is a protected base rather than a public one.
+*/
+template <class T, class Hash = hash<T>, class LockPolicy = AdaptiveMutexLock, class Alloc = typename SafeListConfig<T, LockPolicy>::allocator_type>
+class IndexedSafeList : protected SafeList<T, LockPolicy, Alloc>
+{
+public:
+
+    IndexedSafeList();
+    virtual ~IndexedSafeList();
+
+    using SafeList<T, LockPolicy, Alloc>::empty;
+    using SafeList<T, LockPolicy, Alloc>::size;
+    using SafeList<T, LockPolicy, Alloc>::reserve;
+    using SafeList<T, LockPolicy, Alloc>::visit_all;
+    using SafeList<T, LockPolicy, Alloc>::visit_snapshot;
+    using SafeList<T, LockPolicy, Alloc>::snapshot;
+
+    T pop_front();
+    bool try_pop(T& out);
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+    void remove(const T& arg);
+    bool contains(const T& arg) const;
+
+private:
+    typedef typename SafeList<T, LockPolicy, Alloc>::UnlockGuard UnlockGuard;
+    typedef unordered_multimap<T, typename list<T, Alloc>::iterator, Hash> Index;
+
+    Index index;
+};
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+IndexedSafeList<T, Hash, LockPolicy, Alloc>::IndexedSafeList()
+{
+}
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+IndexedSafeList<T, Hash, LockPolicy, Alloc>::~IndexedSafeList()
+{
+}
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+void IndexedSafeList<T, Hash, LockPolicy, Alloc>::push_back(const T& arg)
+{
+    push_back(T(arg));
+}
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+void IndexedSafeList<T, Hash, LockPolicy, Alloc>::push_back(T&& arg)
+{
+    /* Indexed before the splice, so if the index can't grow the list is left as it was. */
+    list<T, Alloc> node(list<T, Alloc>::get_allocator());
+    node.push_back(std::move(arg));
+    this->Lock();
+    UnlockGuard guard(*this);
+    typename list<T, Alloc>::iterator itr = node.begin();
+    index.insert(typename Index::value_type(*itr, itr));
+    list<T, Alloc>::splice(list<T, Alloc>::end(), node);
+    this->Linked(1);
+    guard.unlock();
+}
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+bool IndexedSafeList<T, Hash, LockPolicy, Alloc>::try_pop(T& out)
+{
+    list<T, Alloc> retired(list<T, Alloc>::get_allocator());
+    bool popped = false;
+    this->Lock();
+    UnlockGuard guard(*this);
+    if (!list<T, Alloc>::empty())
+    {
+        typename list<T, Alloc>::iterator front = list<T, Alloc>::begin();
+        pair<typename Index::iterator, typename Index::iterator> range = index.equal_range(*front);
+        for (typename Index::iterator entry = range.first; entry != range.second; ++entry)
+        {
+            if (entry->second == front)
+            {
+                index.erase(entry);
+                break;
+            }
+        }
+        if (SafeListDeferDestroy<T>::value)
+            this->RetireFront(retired);
+        else
+            this->PopFrontLocked(out);
+        popped = true;
+    }
+    guard.unlock();
+    if (!retired.empty())
+        out = std::move(retired.front());
+    return popped;
+}
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+T IndexedSafeList<T, Hash, LockPolicy, Alloc>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+void IndexedSafeList<T, Hash, LockPolicy, Alloc>::remove(const T& arg)
+{
+    list<T, Alloc> removed(list<T, Alloc>::get_allocator());
+    this->Lock();
+    UnlockGuard guard(*this);
+    pair<typename Index::iterator, typename Index::iterator> range = index.equal_range(arg);
+    for (typename Index::iterator entry = range.first; entry != range.second; ++entry)
+    {
+        typename list<T, Alloc>::iterator itr = entry->second;
+        this->Unlinking(itr, std::next(itr));
+        removed.splice(removed.end(), *this, itr);
+    }
+    index.erase(range.first, range.second);
+    guard.unlock();
+}
+
+template<class T, class Hash, class LockPolicy, class Alloc>
+bool IndexedSafeList<T, Hash, LockPolicy, Alloc>::contains(const T& arg) const
+{
+    bool found;
+    this->LockShared();
+    UnlockGuard guard(*this, &IndexedSafeList::UnlockShared);
+    found = index.find(arg) != index.end();
+    guard.unlock();
+    return found;
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,465 @@
+/***************************************************************************
+                          mappedsafelist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef MAPPEDSAFELIST_H
+#define MAPPEDSAFELIST_H
+
+#include "safelisttraits.h"
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+    MappedSafeList
+
+    Bounded FIFO of trivially copyable items kept in a memory-mapped file,
+    so a queue survives a restart without being rebuilt: reopening the file
+    picks the ring up exactly where it was left, in O(1). The file is a
+    small header (head and tail counters, item size, capacity) followed by
+    a ring of capacity slots, and nothing in it is a pointer, so it can be
+    mapped at any address.
+
+    Every push writes the slot before it advances the tail, and every pop
+    copies the slot out before it advances the head, so the file is always
+    a consistent queue; a crash loses at most the item that was being
+    pushed. If only the process dies, the kernel still writes the mapping
+    back. To survive a power failure as well, pass sync_every: after that
+    many pushes or pops (a whole batch counts as one) the mapping is
+    msync()ed before the call returns. sync() does it on demand.
+
+    The interface and locking follow SafeRingList, with push_back()
+    blocking while the ring is full like a bounded SafeList. Only one
+    process may have the file open at a time; it is flock()ed, and a second
+    open fails. valid() is false if the file could not be opened, mapped or
+    was written with a different item size, and also if its header does
+    not describe a ring that fits in the file, as a truncated or corrupt
+    file's doesn't.
+*/
+template <class T, class LockPolicy = AdaptiveMutexLock>
+class MappedSafeList
+{
+    static_assert(is_trivially_copyable<T>::value, "MappedSafeList needs a trivially copyable T");
+
+public:
+
+    /* capacity is only used when the file is created; an existing file keeps its own. */
+    MappedSafeList(const char* path, size_t capacity, size_t sync_every = 0);
+    virtual ~MappedSafeList();
+
+
+    bool valid() const;
+    bool empty() const;
+    size_t size() const;
+    size_t capacity() const;
+
+    T pop_front();
+    bool try_pop(T& out);
+    T wait_pop();
+    template<class OutputIt>
+    size_t pop_front_n(OutputIt out, size_t max);
+
+    void push_back(const T& arg);
+    bool try_push(const T& arg);
+    template<class InputIt>
+    void push_back(InputIt first, InputIt last);
+
+    /* Flushes the mapping to disk now; returns false if msync() failed. */
+    bool sync();
+
+    template<class Visitor>
+    void visit_all(Visitor&& visitor) const
+    {
+        Lock();
+        for (uint64_t pos = header->head; pos != header->tail; ++pos)
+        {
+            if (!visitor(const_cast<const T&>(slots[pos % header->capacity])))
+                break;
+        }
+        Unlock();
+    }
+
+private:
+    MappedSafeList(const MappedSafeList&);
+    MappedSafeList& operator=(const MappedSafeList&);
+
+    /* Offsets and counters only, so the same bytes are valid wherever they are mapped. */
+    struct Header
+    {
+        uint64_t magic;
+        uint64_t version;
+        uint64_t item_size;
+        uint64_t capacity;
+        uint64_t head;
+        uint64_t tail;
+    };
+
+    static size_t SlotsOffset()
+    {
+        size_t align = alignof(T) > SAFELIST_CACHE_LINE ? alignof(T) : SAFELIST_CACHE_LINE;
+        return (sizeof(Header) + align - 1) / align * align;
+    }
+
+    bool Open(const char* path, size_t capacity);
+    bool Lock() const;
+    bool Unlock() const;
+
+    /*
+        Called with the lock held. Advance() stores a new head or tail, the
+        release fence keeping it behind the slot copies that preceded it,
+        so the file never names a slot that has not been written yet.
+    */
+    static void Advance(uint64_t& counter, uint64_t value);
+    void Counted(size_t ops);
+
+    int fd;
+    void* mapping;
+    size_t mapping_size;
+    Header* header;
+    T* slots;
+    size_t sync_every;
+    size_t ops_since_sync;
+
+    mutable typename SafeListConfig<T, LockPolicy>::lock_type file_mutex;
+    condition_variable_any not_empty_cond;
+    condition_variable_any not_full_cond;
+};
+
+template<class T, class LockPolicy>
+MappedSafeList<T, LockPolicy>::MappedSafeList(const char* path, size_t capacity, size_t sync_every_arg)
+    : fd(-1), mapping(NULL), mapping_size(0), header(NULL), slots(NULL),
+      sync_every(sync_every_arg), ops_since_sync(0)
+{
+    if (!Open(path, capacity))
+    {
+        if (mapping)
+            munmap(mapping, mapping_size);
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+        mapping = NULL;
+        header = NULL;
+    }
+}
+
+template<class T, class LockPolicy>
+MappedSafeList<T, LockPolicy>::~MappedSafeList()
+{
+    if (mapping)
+    {
+        if (sync_every)
+            msync(mapping, mapping_size, MS_SYNC);
+        munmap(mapping, mapping_size);
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::Open(const char* path, size_t capacity)
+{
+    /* "SAFELST1" when read little endian. */
+    const uint64_t magic = 0x3154534c45464153ULL;
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0 || flock(fd, LOCK_EX | LOCK_NB) != 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+        return false;
+
+    Header existing;
+    bool reuse = static_cast<size_t>(info.st_size) >= sizeof(Header) &&
+                 pread(fd, &existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing)) &&
+                 existing.magic == magic;
+    if (reuse)
+    {
+        /* Nothing in an existing header is trusted until it agrees with the file it came from. */
+        if (existing.version != 1 || existing.item_size != sizeof(T) || existing.capacity == 0 ||
+            existing.capacity > (SIZE_MAX - SlotsOffset()) / sizeof(T) ||
+            existing.tail - existing.head > existing.capacity)
+            return false;
+        capacity = static_cast<size_t>(existing.capacity);
+        if (static_cast<uint64_t>(info.st_size) < SlotsOffset() + capacity * sizeof(T))
+            return false;
+    }
+    if (capacity == 0 || capacity > (SIZE_MAX - SlotsOffset()) / sizeof(T))
+        return false;
+
+    mapping_size = SlotsOffset() + capacity * sizeof(T);
+    if (!reuse && static_cast<size_t>(info.st_size) < mapping_size && ftruncate(fd, mapping_size) != 0)
+        return false;
+
+    mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        mapping = NULL;
+        return false;
+    }
+    header = static_cast<Header*>(mapping);
+    slots = reinterpret_cast<T*>(static_cast<char*>(mapping) + SlotsOffset());
+
+    if (!reuse)
+    {
+        Header fresh = { 0, 1, sizeof(T), capacity, 0, 0 };
+        memcpy(header, &fresh, sizeof(fresh));
+        /* The magic goes in last, so a crash part way through creating the file just recreates it. */
+        msync(mapping, sizeof(Header), MS_SYNC);
+        header->magic = magic;
+        msync(mapping, sizeof(Header), MS_SYNC);
+    }
+    return true;
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::Lock() const
+{
+    file_mutex.lock();
+    return true;
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::Unlock() const
+{
+    file_mutex.unlock();
+    return true;
+}
+
+template<class T, class LockPolicy>
+void MappedSafeList<T, LockPolicy>::Advance(uint64_t& counter, uint64_t value)
+{
+    atomic_thread_fence(memory_order_release);
+    counter = value;
+}
+
+template<class T, class LockPolicy>
+void MappedSafeList<T, LockPolicy>::Counted(size_t ops)
+{
+    if (!sync_every || ops == 0)
+        return;
+    ops_since_sync += ops;
+    if (ops_since_sync >= sync_every)
+    {
+        msync(mapping, mapping_size, MS_SYNC);
+        ops_since_sync = 0;
+    }
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::sync()
+{
+    bool synced;
+    Lock();
+    synced = msync(mapping, mapping_size, MS_SYNC) == 0;
+    ops_since_sync = 0;
+    Unlock();
+    return synced;
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::try_push(const T& arg)
+{
+    bool pushed = false;
+    Lock();
+    if (header->tail - header->head < header->capacity)
+    {
+        memcpy(&slots[header->tail % header->capacity], &arg, sizeof(T));
+        Advance(header->tail, header->tail + 1);
+        Counted(1);
+        not_empty_cond.notify_one();
+        pushed = true;
+    }
+    Unlock();
+    return pushed;
+}
+
+template<class T, class LockPolicy>
+void MappedSafeList<T, LockPolicy>::push_back(const T& arg)
+{
+    Lock();
+    while (header->tail - header->head >= header->capacity)
+        not_full_cond.wait(file_mutex);
+    memcpy(&slots[header->tail % header->capacity], &arg, sizeof(T));
+    Advance(header->tail, header->tail + 1);
+    Counted(1);
+    not_empty_cond.notify_one();
+    Unlock();
+}
+
+/* Pushes in runs of whatever fits, waiting for room between runs, and counts each run as one op. */
+template<class T, class LockPolicy>
+template<class InputIt>
+void MappedSafeList<T, LockPolicy>::push_back(InputIt first, InputIt last)
+{
+    Lock();
+    while (first != last)
+    {
+        while (header->tail - header->head >= header->capacity)
+            not_full_cond.wait(file_mutex);
+        uint64_t tail = header->tail;
+        while (first != last && tail - header->head < header->capacity)
+        {
+            T item = *first;
+            memcpy(&slots[tail % header->capacity], &item, sizeof(T));
+            ++tail;
+            ++first;
+        }
+        Advance(header->tail, tail);
+        Counted(1);
+        not_empty_cond.notify_all();
+    }
+    Unlock();
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::try_pop(T& out)
+{
+    bool popped = false;
+    Lock();
+    if (header->head != header->tail)
+    {
+        memcpy(&out, &slots[header->head % header->capacity], sizeof(T));
+        Advance(header->head, header->head + 1);
+        Counted(1);
+        not_full_cond.notify_one();
+        popped = true;
+    }
+    Unlock();
+    return popped;
+}
+
+template<class T, class LockPolicy>
+T MappedSafeList<T, LockPolicy>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T, class LockPolicy>
+T MappedSafeList<T, LockPolicy>::wait_pop()
+{
+    T ret_val = T();
+    Lock();
+    while (header->head == header->tail)
+        not_empty_cond.wait(file_mutex);
+    memcpy(&ret_val, &slots[header->head % header->capacity], sizeof(T));
+    Advance(header->head, header->head + 1);
+    Counted(1);
+    not_full_cond.notify_one();
+    Unlock();
+    return ret_val;
+}
+
+template<class T, class LockPolicy>
+template<class OutputIt>
+size_t MappedSafeList<T, LockPolicy>::pop_front_n(OutputIt out, size_t max)
+{
+    size_t count = 0;
+    Lock();
+    uint64_t head = header->head;
+    while (count < max && head != header->tail)
+    {
+        T item;
+        memcpy(&item, &slots[head % header->capacity], sizeof(T));
+        *out++ = item;
+        ++head;
+        ++count;
+    }
+    Advance(header->head, head);
+    if (count)
+    {
+        Counted(1);
+        not_full_cond.notify_all();
+    }
+    Unlock();
+    return count;
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::valid() const
+{
+    return header != NULL;
+}
+
+template<class T, class LockPolicy>
+size_t MappedSafeList<T, LockPolicy>::size() const
+{
+    size_t size = 0;
+    Lock();
+    size = static_cast<size_t>(header->tail - header->head);
+    Unlock();
+    return size;
+}
+
+template<class T, class LockPolicy>
+bool MappedSafeList<T, LockPolicy>::empty() const
+{
+    return size() == 0;
+}
+
+template<class T, class LockPolicy>
+size_t MappedSafeList<T, LockPolicy>::capacity() const
+{
+    return static_cast<size_t>(header->capacity);
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,324 @@
+/***************************************************************************
+                          numasafelist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef NUMASAFELIST_H
+#define NUMASAFELIST_H
+
+#include "safelist.h"
+#include <cstdint>
+#include <cstdio>
+#include <new>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace std;
+
+/*
+    SafeListNumaTopology
+
+    Which CPUs belong to which NUMA node, read once from
+    /sys/devices/system/node. Nodes are numbered densely from 0 here;
+    node_id() gives the kernel's id for a node, which is what mbind() and
+    NodePoolAllocator want (they usually match). On other systems, or if
+    /sys can't be read, there is one node holding every CPU.
+*/
+class SafeListNumaTopology
+{
+public:
+    static const SafeListNumaTopology& get()
+    {
+        static const SafeListNumaTopology topology;
+        return topology;
+    }
+
+    size_t node_count() const { return node_ids.size(); }
+    int node_id(size_t node) const { return node_ids[node]; }
+
+    /* Dense node number of cpu, or 0 if unknown. */
+    size_t node_of_cpu(int cpu) const
+    {
+        if (cpu < 0 || static_cast<size_t>(cpu) >= cpu_nodes.size())
+            return 0;
+        return cpu_nodes[cpu];
+    }
+
+    /* Node of the CPU the caller is running on right now. */
+    size_t current_node() const
+    {
+        if (node_ids.size() == 1)
+            return 0;
+#ifdef __linux__
+        return node_of_cpu(sched_getcpu());
+#else
+        return 0;
+#endif
+    }
+
+private:
+    SafeListNumaTopology()
+    {
+#ifdef __linux__
+        vector<int> online = ParseList("/sys/devices/system/node/online");
+        for (size_t i = 0; i < online.size(); ++i)
+        {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", online[i]);
+            vector<int> cpus = ParseList(path);
+            if (cpus.empty())
+                continue;
+            for (size_t c = 0; c < cpus.size(); ++c)
+            {
+                if (static_cast<size_t>(cpus[c]) >= cpu_nodes.size())
+                    cpu_nodes.resize(cpus[c] + 1, 0);
+                cpu_nodes[cpus[c]] = node_ids.size();
+            }
+            node_ids.push_back(online[i]);
+        }
+#endif
+        if (node_ids.empty())
+        {
+            node_ids.push_back(0);
+            cpu_nodes.clear();
+        }
+    }
+
+    /* Reads a kernel list such as "0-3,8-11". */
+    static vector<int> ParseList(const char* path)
+    {
+        vector<int> values;
+        FILE* file = fopen(path, "r");
+        if (!file)
+            return values;
+        int first;
+        while (fscanf(file, "%d", &first) == 1)
+        {
+            int last = first;
+            int separator = fgetc(file);
+            if (separator == '-')
+            {
+                if (fscanf(file, "%d", &last) != 1)
+                    break;
+                separator = fgetc(file);
+            }
+            for (int value = first; value <= last; ++value)
+                values.push_back(value);
+            if (separator != ',')
+                break;
+        }
+        fclose(file);
+        return values;
+    }
+
+    vector<int> node_ids;
+    vector<size_t> cpu_nodes;
+};
+
+/*
+    NumaSafeList
+
+    One SafeList per NUMA node, each drawing its nodes from a
+    NodePoolAllocator whose memory sits on that node. push_back() goes to
+    the list of the node the caller is running on, and try_pop() takes
+    from the local list first and only then steals from the other nodes,
+    nearest first by number. Items therefore usually stay on the socket
+    that produced them, and so does each list's lock; consumers only pay
+    for remote memory once their own node has run dry.
+
+    Ordering is as for ShardedSafeList: FIFO per node, not across nodes.
+    On a machine with one node this is a SafeList with a pooled allocator.
+*/
+template <class T, class LockPolicy = AdaptiveMutexLock>
+class NumaSafeList
+{
+public:
+
+    NumaSafeList();
+    virtual ~NumaSafeList();
+
+
+    bool empty() const;
+    size_t size() const;
+    size_t node_count() const;
+
+    T pop_front();
+    bool try_pop(T& out);
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+
+    /* Pre-sizes every node's pool for n items, on that node. */
+    void reserve(size_t n);
+
+    /* Visits one node's list at a time; false from the visitor stops the whole walk. */
+    template<class Visitor>
+    void visit_all(Visitor&& visitor) const;
+
+private:
+    NumaSafeList(const NumaSafeList&);
+    NumaSafeList& operator=(const NumaSafeList&);
+
+    typedef SafeList<T, LockPolicy, NodePoolAllocator<T> > NodeList;
+
+    /* Placed by hand, like ShardedSafeList's shards, to keep each list on its own cache lines. */
+    void* list_storage;
+    NodeList* lists;
+    size_t lists_size;
+};
+
+template<class T, class LockPolicy>
+NumaSafeList<T, LockPolicy>::NumaSafeList()
+{
+    const SafeListNumaTopology& topology = SafeListNumaTopology::get();
+    lists_size = topology.node_count();
+
+    list_storage = ::operator new(lists_size * sizeof(NodeList) + SAFELIST_CACHE_LINE);
+    size_t misalignment = reinterpret_cast<uintptr_t>(list_storage) % SAFELIST_CACHE_LINE;
+    lists = reinterpret_cast<NodeList*>(static_cast<char*>(list_storage) +
+                                        (misalignment ? SAFELIST_CACHE_LINE - misalignment : 0));
+    for (size_t i = 0; i < lists_size; ++i)
+    {
+        int node_id = lists_size > 1 ? topology.node_id(i) : -1;
+        new (&lists[i]) NodeList(NodePoolAllocator<T>(node_id));
+    }
+}
+
+template<class T, class LockPolicy>
+NumaSafeList<T, LockPolicy>::~NumaSafeList()
+{
+    for (size_t i = 0; i < lists_size; ++i)
+        lists[i].~NodeList();
+    ::operator delete(list_storage);
+}
+
+template<class T, class LockPolicy>
+size_t NumaSafeList<T, LockPolicy>::node_count() const
+{
+    return lists_size;
+}
+
+template<class T, class LockPolicy>
+void NumaSafeList<T, LockPolicy>::push_back(const T& arg)
+{
+    lists[SafeListNumaTopology::get().current_node()].push_back(arg);
+}
+
+template<class T, class LockPolicy>
+void NumaSafeList<T, LockPolicy>::push_back(T&& arg)
+{
+    lists[SafeListNumaTopology::get().current_node()].push_back(std::move(arg));
+}
+
+template<class T, class LockPolicy>
+bool NumaSafeList<T, LockPolicy>::try_pop(T& out)
+{
+    size_t home = SafeListNumaTopology::get().current_node();
+    for (size_t i = 0; i < lists_size; ++i)
+    {
+        NodeList& candidate = lists[(home + i) % lists_size];
+        if (!candidate.empty() && candidate.try_pop(out))
+            return true;
+    }
+    return false;
+}
+
+template<class T, class LockPolicy>
+T NumaSafeList<T, LockPolicy>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T, class LockPolicy>
+void NumaSafeList<T, LockPolicy>::reserve(size_t n)
+{
+    for (size_t i = 0; i < lists_size; ++i)
+        lists[i].reserve(n);
+}
+
+template<class T, class LockPolicy>
+size_t NumaSafeList<T, LockPolicy>::size() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < lists_size; ++i)
+        total += lists[i].size();
+    return total;
+}
+
+template<class T, class LockPolicy>
+bool NumaSafeList<T, LockPolicy>::empty() const
+{
+    for (size_t i = 0; i < lists_size; ++i)
+    {
+        if (!lists[i].empty())
+            return false;
+    }
+    return true;
+}
+
+template<class T, class LockPolicy>
+template<class Visitor>
+void NumaSafeList<T, LockPolicy>::visit_all(Visitor&& visitor) const
+{
+    bool keep_going = true;
+    for (size_t i = 0; i < lists_size && keep_going; ++i)
+    {
+        lists[i].visit_all([&](const T& item)
+        {
+            keep_going = visitor(item);
+            return keep_going;
+        });
+    }
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
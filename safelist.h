@@ -11,279 +11,2120 @@
 #define SAFELIST_H
 
 #include "threadutils.h"
+#include "safelistlock.h"
+#include "safelisttraits.h"
+#include "safelistpool.h"
+#include "safelistnotify.h"
+#include "safelistio.h"
 #include <list>
 #include <functional>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <algorithm>
+#include <utility>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include <unordered_map>
+
+/* Default number of slots in a SafeList<T, LockFreePolicy> ring. Rounded up to a power of 2. */
+#ifndef SAFELIST_LOCKFREE_CAPACITY
+#define SAFELIST_LOCKFREE_CAPACITY 1024
+#endif
+
+/* parallel_visit() and friends never hand a worker fewer items than this. */
+#ifndef SAFELIST_PARALLEL_MIN_CHUNK
+#define SAFELIST_PARALLEL_MIN_CHUNK 4096
+#endif
 
 using namespace std;
 
-/**
-  *@author Bob Burrough
-  */
+/*
+    Backend selection
+
+    SafeList<T, LockPolicy, Alloc> is the original std::list guarded by
+    safelist_mutex, which is a LockPolicy (see safelistlock.h). Alloc is
+    the list's allocator; NodePoolAllocator (see safelistpool.h) keeps
+    push/pop away from malloc. LockPolicy may instead be a SafeListTraits
+    (see safelisttraits.h), which also picks the hook policy and the
+    default allocator: SafeList<T, SafeListTraits<...> >.
+    SafeList<T, LockFreePolicy> is a bounded lock-free
+    multi-producer/multi-consumer ring with the same
+    push_back()/pop_front()/empty()/size() surface, so the two can be
+    swapped and compared under contention.
+*/
+struct LockFreePolicy {};
+
+/*
+    SafeListStats
+
+    Returned by SafeList::stats(). Only lists with SafeListWithStats (see
+    safelisttraits.h) collect, which building with SAFELIST_STATS defined
+    makes the default; for the rest nothing is measured and stats()
+    returns zeros.
+
+    Lock hold times are measured from acquisition to release, excluding any
+    time spent asleep in a condition variable. An acquisition counts as
+    contended when a try_lock() first attempt fails. Enqueue to dequeue
+    latency is sampled on one push in every SAFELIST_STATS_SAMPLE_RATE and
+    recorded in power of 2 nanosecond buckets: latency_histogram[i] counts
+    samples in [2^i, 2^(i+1)) ns. The enqueue times of samples still in the
+    list are kept in a fixed table of SAFELIST_STATS_IN_FLIGHT entries, so
+    that sampling never allocates under the lock it is timing; a sample
+    that falls due while the table is full is skipped.
+
+    Every counter is only ever written while the list's lock is held, so the
+    counters live on cache lines the writing thread already owns and need
+    no atomics. Reading them takes the lock once.
+*/
+#ifndef SAFELIST_STATS_SAMPLE_RATE
+#define SAFELIST_STATS_SAMPLE_RATE 64
+#endif
+
+#ifndef SAFELIST_STATS_IN_FLIGHT
+#define SAFELIST_STATS_IN_FLIGHT 16
+#endif
+
+#define SAFELIST_STATS_BUCKETS 40
+
+struct SafeListStats
+{
+    SafeListStats()
+        : lock_acquisitions(0), contended_acquisitions(0), total_hold_ns(0), max_hold_ns(0),
+          pushes(0), pops(0), high_water(0), latency_samples(0)
+    {
+        for (int i = 0; i < SAFELIST_STATS_BUCKETS; ++i)
+            latency_histogram[i] = 0;
+    }
+
+    unsigned long long lock_acquisitions;
+    unsigned long long contended_acquisitions;
+    unsigned long long total_hold_ns;
+    unsigned long long max_hold_ns;
+    unsigned long long pushes;
+    unsigned long long pops;
+    size_t high_water;
+    unsigned long long latency_samples;
+    unsigned long long latency_histogram[SAFELIST_STATS_BUCKETS];
+};
+
+/*
+    SafeListDeferDestroy
+
+    Whether items leaving a SafeList are destroyed after the lock has been
+    released instead of while it is held. When set, pops splice the node
+    onto a local list (an O(1) relink) and the item is moved out and its
+    node freed after Unlock(), so an expensive ~T() never lengthens the
+    critical section. remove(), remove_if(), erase() and pop_front_n()
+    always work that way. The default is on for any T that is not
+    trivially destructible; for the rest, freeing the node in place is
+    cheaper than moving it. Specialize it to force either choice.
+*/
+template<class T>
+struct SafeListDeferDestroy
+{
+    static const bool value = !is_trivially_destructible<T>::value;
+};
+
+/*
+    SafeListHandle
+
+    Returned by SafeList::push_back_handle(). It names one item for as long
+    as that item is in the list; once the item has been popped or removed
+    the handle goes stale and erase() on it simply returns false, even if
+    the memory has since been reused for a new item.
+*/
+struct SafeListHandle
+{
+    SafeListHandle() : node(NULL), serial(0) {}
+
+    const void* node;
+    unsigned long long serial;
+};
+
+/*
+    Feature state
+
+    Each optional SafeList feature (see safelisttraits.h) keeps its state
+    in a base class of SafeList, specialised to an empty class when the
+    feature is off. Both forms provide the members that SafeList's common
+    paths call, so those calls cost nothing for a disabled feature, and
+    enabled says which one it is. Everything is called with the lock held.
+*/
+template<bool Enabled>
+struct SafeListBlockingState
+{
+    static const bool enabled = false;
+    void Linked(size_t) {}
+};
+
+template<>
+struct SafeListBlockingState<true>
+{
+    static const bool enabled = true;
+    SafeListBlockingState() : waiting_consumers(0) {}
+
+    void Linked(size_t count)
+    {
+        if (!waiting_consumers)
+            return;
+        if (count == 1)
+            safelist_cond.notify_one();
+        else
+            safelist_cond.notify_all();
+    }
+
+    /* Signalled when items arrive and there is a consumer parked in wait_pop(). */
+    condition_variable_any safelist_cond;
+    size_t waiting_consumers;
+};
+
+template<bool Enabled>
+struct SafeListBoundsState
+{
+    static const bool enabled = false;
+    explicit SafeListBoundsState(size_t) {}
+
+    size_t Limit() const { return 0; }
+    template<class Iterator>
+    void Unlinking(Iterator, Iterator) {}
+};
+
+template<>
+struct SafeListBoundsState<true>
+{
+    static const bool enabled = true;
+    explicit SafeListBoundsState(size_t capacity) : max_items(capacity), waiting_producers(0) {}
+
+    size_t Limit() const { return max_items; }
+
+    template<class Iterator>
+    void Unlinking(Iterator first, Iterator last)
+    {
+        if (!waiting_producers || first == last)
+            return;
+        if (std::next(first) == last)
+            not_full_cond.notify_one();
+        else
+            not_full_cond.notify_all();
+    }
+
+    /* 0 means unbounded. not_full_cond is signalled when items leave and a producer is waiting for room. */
+    size_t max_items;
+    condition_variable_any not_full_cond;
+    size_t waiting_producers;
+};
+
+template<bool Enabled>
+struct SafeListNotifierState
+{
+    static const bool enabled = false;
+    void Linked(size_t, size_t) {}
+};
+
+template<>
+struct SafeListNotifierState<true>
+{
+    static const bool enabled = true;
+    SafeListNotifierState() : notifier(NULL) {}
+
+    /* count items were just linked, leaving size in the list. */
+    void Linked(size_t count, size_t size)
+    {
+        if (notifier && size == count)
+            notifier->notify();
+    }
+
+    /* See set_notifier(). */
+    SafeListNotifier* notifier;
+};
+
+template<bool Enabled, class Iterator>
+struct SafeListHandleState
+{
+    static const bool enabled = false;
+    template<class List, class ListIterator>
+    void Unlinking(const List&, ListIterator, ListIterator) {}
+};
+
+template<class Iterator>
+struct SafeListHandleState<true, Iterator>
+{
+    static const bool enabled = true;
+    SafeListHandleState() : next_handle_serial(0) {}
+
+    template<class List, class ListIterator>
+    void Unlinking(const List& items, ListIterator first, ListIterator last)
+    {
+        if (handles.empty())
+            return;
+        if (first == items.begin() && last == items.end())
+        {
+            handles.clear();
+            return;
+        }
+        for (; first != last; ++first)
+            handles.erase(&*first);
+    }
+
+    /* Items handed out by push_back_handle(), keyed by node address. */
+    typedef pair<Iterator, unsigned long long> HandleEntry;
+    unordered_map<const void*, HandleEntry> handles;
+    unsigned long long next_handle_serial;
+};
+
+template<bool Enabled, class T>
+struct SafeListSnapshotState
+{
+    static const bool enabled = false;
+    void Changed() {}
+    shared_ptr<const vector<T> > Cached() const { return shared_ptr<const vector<T> >(); }
+    void Cache(const shared_ptr<const vector<T> >&) const {}
+};
+
+template<class T>
+struct SafeListSnapshotState<true, T>
+{
+    static const bool enabled = true;
+    SafeListSnapshotState() : generation(0), cached_generation(0) {}
+
+    void Changed() { ++generation; }
+
+    shared_ptr<const vector<T> > Cached() const
+    {
+        if (cached_generation != generation)
+            return shared_ptr<const vector<T> >();
+        return cached_snapshot.lock();
+    }
+
+    void Cache(const shared_ptr<const vector<T> >& items) const
+    {
+        cached_snapshot = items;
+        cached_generation = generation;
+    }
+
+    /*
+        Bumped by every change to the list. snapshot() reuses the last copy
+        for as long as the generation it was taken at is still current and
+        the copy is still alive; the list only holds a weak reference, so a
+        snapshot goes away as soon as its last user lets go of it.
+    */
+    size_t generation;
+    mutable weak_ptr<const vector<T> > cached_snapshot;
+    mutable size_t cached_generation;
+};
+
+template<bool Enabled>
+struct SafeListStatsState
+{
+    static const bool enabled = false;
+
+    template<class Lock>
+    void Acquire(Lock& mutex) const { mutex.lock(); }
+    void HoldStarted() const {}
+    void HoldEnded() const {}
+    template<class List>
+    void Linked(const List&, size_t) {}
+    template<class Iterator>
+    void Unlinking(Iterator, Iterator) {}
+    SafeListStats Get() const { return SafeListStats(); }
+    void Reset(size_t) {}
+};
+
+template<>
+struct SafeListStatsState<true>
+{
+    static const bool enabled = true;
+    SafeListStatsState() : lock_start_ns(0), pushes_until_sample(SAFELIST_STATS_SAMPLE_RATE), stamps_in_flight(0)
+    {
+        for (int i = 0; i < SAFELIST_STATS_IN_FLIGHT; ++i)
+            stamps[i].node = NULL;
+    }
+
+    static unsigned long long StatsNow()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    template<class Lock>
+    void Acquire(Lock& mutex) const
+    {
+        if (!mutex.try_lock())
+        {
+            mutex.lock();
+            ++counters.contended_acquisitions;
+        }
+        HoldStarted();
+    }
+
+    void HoldStarted() const
+    {
+        ++counters.lock_acquisitions;
+        lock_start_ns = StatsNow();
+    }
+
+    void HoldEnded() const
+    {
+        unsigned long long held = StatsNow() - lock_start_ns;
+        counters.total_hold_ns += held;
+        if (held > counters.max_hold_ns)
+            counters.max_hold_ns = held;
+    }
+
+    template<class List>
+    void Linked(const List& items, size_t count)
+    {
+        counters.pushes += count;
+        if (items.size() > counters.high_water)
+            counters.high_water = items.size();
+        if (pushes_until_sample <= count)
+        {
+            Stamp(&items.back());
+            pushes_until_sample = SAFELIST_STATS_SAMPLE_RATE;
+        }
+        else
+            pushes_until_sample -= count;
+    }
+
+    void Stamp(const void* node)
+    {
+        if (stamps_in_flight == SAFELIST_STATS_IN_FLIGHT)
+            return;
+        int slot = 0;
+        while (stamps[slot].node)
+            ++slot;
+        stamps[slot].node = node;
+        stamps[slot].enqueued_ns = StatsNow();
+        ++stamps_in_flight;
+    }
+
+    template<class Iterator>
+    void Unlinking(Iterator first, Iterator last)
+    {
+        for (; first != last; ++first)
+            Unlinked(&*first);
+    }
+
+    void Unlinked(const void* node)
+    {
+        ++counters.pops;
+        if (!stamps_in_flight)
+            return;
+        int slot = 0;
+        while (slot < SAFELIST_STATS_IN_FLIGHT && stamps[slot].node != node)
+            ++slot;
+        if (slot == SAFELIST_STATS_IN_FLIGHT)
+            return;
+
+        unsigned long long latency = StatsNow() - stamps[slot].enqueued_ns;
+        stamps[slot].node = NULL;
+        --stamps_in_flight;
+        int bucket = 0;
+        while (latency > 1 && bucket < SAFELIST_STATS_BUCKETS - 1)
+        {
+            latency >>= 1;
+            ++bucket;
+        }
+        ++counters.latency_histogram[bucket];
+        ++counters.latency_samples;
+    }
+
+    SafeListStats Get() const { return counters; }
+
+    void Reset(size_t size)
+    {
+        counters = SafeListStats();
+        counters.high_water = size;
+    }
+
+    mutable SafeListStats counters;
+    mutable unsigned long long lock_start_ns;
+    unsigned long long pushes_until_sample;
+
+    /* Sampled nodes still in the list; a NULL node marks a free entry. */
+    struct StampEntry
+    {
+        const void* node;
+        unsigned long long enqueued_ns;
+    };
+    StampEntry stamps[SAFELIST_STATS_IN_FLIGHT];
+    int stamps_in_flight;
+};
+
+/* All of the above for one SafeList, picked by its features. */
+template<class T, class Alloc, unsigned Features>
+struct SafeListState
+    : SafeListBlockingState<(Features & SafeListWithBlocking) != 0>,
+      SafeListBoundsState<(Features & SafeListWithBounds) != 0>,
+      SafeListNotifierState<(Features & SafeListWithNotifier) != 0>,
+      SafeListHandleState<(Features & SafeListWithHandles) != 0, typename list<T, Alloc>::iterator>,
+      SafeListSnapshotState<(Features & SafeListWithSnapshotCache) != 0, T>,
+      SafeListStatsState<(Features & SafeListWithStats) != 0>
+{
+    typedef SafeListBlockingState<(Features & SafeListWithBlocking) != 0> Blocking;
+    typedef SafeListBoundsState<(Features & SafeListWithBounds) != 0> Bounds;
+    typedef SafeListNotifierState<(Features & SafeListWithNotifier) != 0> Notifier;
+    typedef SafeListHandleState<(Features & SafeListWithHandles) != 0, typename list<T, Alloc>::iterator> Handles;
+    typedef SafeListSnapshotState<(Features & SafeListWithSnapshotCache) != 0, T> Snapshots;
+    typedef SafeListStatsState<(Features & SafeListWithStats) != 0> Stats;
+
+    explicit SafeListState(size_t capacity) : Bounds(capacity) {}
+};
+
+/**
+  *@author Bob Burrough
+  */
+
+template <class T, class LockPolicy = AdaptiveMutexLock, class Alloc = typename SafeListConfig<T, LockPolicy>::allocator_type>
+class alignas(SAFELIST_CACHE_LINE) SafeList : protected list<T, Alloc>, private SafeListConfig<T, LockPolicy>::hooks_type,
+                                              private SafeListState<T, Alloc, SafeListConfig<T, LockPolicy>::features>
+{
+public:
+
+    SafeList();
+    explicit SafeList(const Alloc& alloc);
+
+    /*
+        Bounded lists
+
+        Only for lists built with SafeListWithBounds, which a plain
+        SafeList<T> is not (see safelisttraits.h). A list constructed with
+        a capacity never holds more than that many items. push_back() and friends block until a consumer makes room,
+        which throttles producers instead of letting the list grow without
+        limit. try_push() returns false instead of blocking, and push_for()
+        gives up after a timeout. The capacity is fixed for the life of the
+        list and is passed to reserve() up front, so a pooled allocator is
+        pre-sized for it. A capacity of 0 means unbounded. Without
+        SafeListWithBounds there is no capacity constructor, try_push()
+        and push_for() always succeed and capacity() is 0.
+    */
+    explicit SafeList(size_t capacity, const Alloc& alloc = Alloc());
+    size_t capacity() const;
+    bool try_push(const T& arg);
+    bool try_push(T&& arg);
+    template<class Rep, class Period>
+    bool push_for(const T& arg, const chrono::duration<Rep, Period>& timeout);
+    template<class Rep, class Period>
+    bool push_for(T&& arg, const chrono::duration<Rep, Period>& timeout);
+
+    virtual ~SafeList();
+
+
+    bool empty() const;
+
+    T pop_front();
+
+    /*
+        try_pop
+
+        Moves the front item into out and returns true, or returns false if
+        the list is empty. Unlike pop_front() this never needs a NULL-like
+        "nothing there" value, so it suits move-only types such as
+        unique_ptr and avoids constructing a throwaway T.
+    */
+    bool try_pop(T& out);
+
+    /*
+        wait_pop
+
+        Like pop_front(), but if the list is empty the caller is parked on
+        a condition variable until push_back() or insert() hands it an item.
+        Use this in consumer threads instead of spinning on pop_front().
+        Needs SafeListWithBlocking, as does wait_pop_for(); a plain
+        SafeList<T> has neither.
+    */
+    T wait_pop();
+
+    /*
+        wait_pop_for
+
+        Same as wait_pop(), but gives up after the timeout has elapsed. Returns
+        T() (NULL for pointers, like pop_front() on an empty list) if nothing
+        arrived in time.
+    */
+    template<class Rep, class Period>
+    T wait_pop_for(const chrono::duration<Rep, Period>& timeout);
+
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+
+    /* Constructs the new item in place at the back of the list. */
+    template<class... Args>
+    void emplace_back(Args&&... args);
+
+    /*
+        size / empty / size_exact
+
+        size() and empty() are a relaxed load of a counter that is updated
+        whenever the lock is released, so they never touch safelist_mutex and
+        are cheap enough to poll for load balancing. The answer may already
+        be stale when it arrives. size_exact() takes the lock and returns
+        the size as of that moment.
+    */
+    size_t size() const;
+    size_t size_exact() const;
+
+    /* True if some item == arg. A linear scan; see IndexedSafeList for a hashed one. */
+    bool contains(const T& arg) const;
+
+    void remove(const T& arg);
+
+    /*
+        remove_if / extract_if
+
+        Unlink every item for which pred returns true, in a single pass and
+        a single lock acquisition, and return how many there were.
+        remove_if() destroys them after the lock has been released;
+        extract_if() splices them onto the end of out instead, keeping
+        their order. pred runs with the lock held, so it must not call back
+        into the list. If pred throws, the lock is released and the
+        exception propagates; the items matched before it have already
+        left the list, and extract_if() has put them on out.
+    */
+    template<class Predicate>
+    size_t remove_if(Predicate&& pred);
+    template<class Predicate>
+    size_t extract_if(Predicate&& pred, list<T, Alloc>& out);
+
+    /*
+        push_back_handle / erase
+
+        push_back_handle() pushes like push_back() and returns a handle to
+        the new item. erase() unlinks the item a handle names in O(1), for
+        cancelling a queued item without remove()'s linear scan. It returns
+        false if the item has already left the list.
+
+        Both need SafeListWithHandles, which a plain SafeList<T> doesn't
+        have. Handles are tracked in a hash index keyed by node. Lists that
+        never hand one out pay nothing beyond an empty() check when items
+        leave.
+    */
+    SafeListHandle push_back_handle(const T& arg);
+    SafeListHandle push_back_handle(T&& arg);
+    bool erase(const SafeListHandle& handle);
+
+    /*
+        reserve
+
+        Pre-sizes the allocator for n items if it is a pooled allocator such
+        as NodePoolAllocator, so the list never has to grow its pool while
+        running. Does nothing for std::allocator.
+    */
+    void reserve(size_t n);
+
+    /* See SafeListStats. Both are no-ops unless the list has SafeListWithStats. */
+    SafeListStats stats() const;
+    void reset_stats();
+
+    /*
+        set_notifier
+
+        Registers a SafeListNotifier that is told whenever the list goes
+        from empty to non-empty, which is how SafeListSelector waits on
+        several lists at once and how SafeListFdNotifier hands an event
+        loop a pollable descriptor. Pass NULL to detach. Once this returns, the
+        previous notifier will not be called again. Needs
+        SafeListWithNotifier, which a plain SafeList<T> doesn't have;
+        SafeListSelector::List has it.
+    */
+    void set_notifier(SafeListNotifier* new_notifier);
+
+    /*
+        Batch operations
+
+        Each of these takes safelist_mutex exactly once no matter how many
+        items are moved, so bursty producers and consumers pay one lock
+        round trip per burst instead of one per item.
+
+        push_back(first, last) builds the new nodes before taking the lock
+        and splices them onto the end. pop_front_n() unlinks up to max items
+        under the lock and writes them to out after releasing it; it returns
+        the number written. drain_into() splices everything onto the end of
+        the caller's list and returns how many items it moved.
+    */
+    template<class InputIt>
+    void push_back(InputIt first, InputIt last);
+
+    template<class OutputIt>
+    size_t pop_front_n(OutputIt out, size_t max);
+
+    size_t drain_into(list<T, Alloc>& out);
+
+    /*
+        visit_all
+
+        Iterate over the list in a thread-safe manner. Your provided
+        visitor is called, passing the item as the argument. Your visitor
+        returns true to continue iterating, or returns false to terminate
+        iteration before reaching the end of the list.
+
+        The list is locked while your visitor runs, so the visitor must not
+        call back into the same list unless the list was declared with
+        RecursiveMutexLock.
+
+        The visitor is any callable taking const T& and returning bool. It
+        is taken as a template parameter rather than a std::function so a
+        lambda inlines into the loop and nothing is heap allocated; passing
+        a std::function still works.
+
+        With a shared lock policy such as SharedMutexLock the lock is taken
+        shared, so several visit_all() calls can run at once. If the
+        visitor throws, the lock is released and the exception propagates.
+    */
+    template<class Visitor>
+    void visit_all(Visitor&& visitor) const
+    {
+        LockShared();
+        UnlockGuard guard(*this, &SafeList::UnlockShared);
+        for (typename list<T, Alloc>::const_iterator itr = list<T, Alloc>::begin(); itr != list<T, Alloc>::end(); ++itr)
+        {
+            if (!visitor(*itr))
+                break;
+        }
+        guard.unlock();
+    }
+
+    /*
+        visit_all_mut
+
+        Same as visit_all(), but the visitor gets a T& and may modify the
+        item in place.
+    */
+    template<class Visitor>
+    void visit_all_mut(Visitor&& visitor)
+    {
+        Lock();
+        UnlockGuard guard(*this);
+        Snapshots::Changed();
+        for (typename list<T, Alloc>::iterator itr = list<T, Alloc>::begin(); itr != list<T, Alloc>::end(); ++itr)
+        {
+            if (!visitor(*itr))
+                break;
+        }
+        guard.unlock();
+    }
+
+    /*
+        visit_snapshot
+
+        Like visit_all(), but the visitor runs against a snapshot of the
+        list and without holding safelist_mutex, so a slow visitor doesn't
+        stall producers and consumers. Items pushed or popped while the
+        visit is running are not seen by it.
+
+        snapshot() returns the snapshot itself. It is immutable and shared.
+        With SafeListWithSnapshotCache, a call reuses the last snapshot,
+        for the cost of a reference count increment, when the list has not
+        changed since it was taken and someone still holds it. If either
+        is not the case, the list is copied under the lock. Without the
+        feature every call copies. The list itself only keeps a weak
+        reference, so a snapshot (and the copies of the items in it) goes
+        away as soon as its last user lets go of it. T must be copy
+        constructible to use either.
+
+        The copy is O(n) and holds the lock for its whole length, so a list
+        that is written to between snapshots pays that on every one; the
+        cache only helps lists that are read more often than they change.
+    */
+    template<class Visitor>
+    void visit_snapshot(Visitor&& visitor) const;
+    shared_ptr<const vector<T> > snapshot() const;
+
+    /*
+        parallel_visit / parallel_for_each / parallel_visit_snapshot
+
+        Split the list into parts and run the visitor on all of them at
+        once. The caller runs the first part itself and hands the rest to
+        executor, which is any callable taking a function<void()> and
+        running it on some other thread, e.g. a thread pool's submit(). The
+        call returns once every part is done. parts defaults to
+        hardware_concurrency(), and no part is smaller than
+        SAFELIST_PARALLEL_MIN_CHUNK items, so short lists are visited
+        inline.
+
+        parallel_visit() has visit_all()'s contract, except that false
+        from the visitor stops the other parts only at their next item.
+        parallel_for_each() hands out T& like visit_all_mut() and ignores
+        the return value. Both hold the lock until every part has finished,
+        so the hold time shrinks with the number of workers, but it still
+        has to walk the list once to find where each part starts.
+        parallel_visit_snapshot() runs against snapshot() and never holds
+        the lock while visiting, which is the better choice for long
+        monitoring sweeps.
+
+        The visitor is called from several threads at once, so it has to be
+        safe to do that. If it throws, the first exception is rethrown
+        from the call once all parts have finished and the lock is released.
+        The same goes for the executor failing to accept a part; the parts
+        it did accept still run to completion first.
+    */
+    template<class Executor, class Visitor>
+    void parallel_visit(Executor&& executor, Visitor&& visitor, size_t parts = 0) const;
+    template<class Executor, class Function>
+    void parallel_for_each(Executor&& executor, Function&& function, size_t parts = 0);
+    template<class Executor, class Visitor>
+    void parallel_visit_snapshot(Executor&& executor, Visitor&& visitor, size_t parts = 0) const;
+
+    /*
+        write_to / load_from
+
+        Bulk export and import for trivially copyable T, in the format
+        described at SafeListStreamHeader. write_to() takes a snapshot()
+        and streams it with the lock released, so writers are held up only
+        while the snapshot is copied (not at all if the list has
+        SafeListWithSnapshotCache and the last snapshot is still current).
+        The items are already contiguous in the snapshot, so they go out as
+        they are, without a call per item: sink is called as
+        sink(const iovec* iov, int count), writev() style, with at most
+        SAFELIST_STREAM_IOV buffers of at most chunk_size bytes each, and
+        returns false to give up. SafeListFdSink is such a sink for a
+        socket or file.
+
+        load_from() reads a stream back and appends its items to the list.
+        source is called as source(void* buffer, size_t bytes) and returns
+        how many bytes it read; SafeListFdSource is one. Nothing is pushed
+        unless the whole stream was read and the header matches T; the
+        items then go in as one batch, as with push_back(first, last). The
+        count in the header is not trusted up front: items are read
+        SAFELIST_STREAM_CHUNK bytes at a time, so a corrupt header fails on
+        the first short read instead of allocating for items that never
+        arrive.
+    */
+    template<class Sink>
+    bool write_to(Sink&& sink, size_t chunk_size = SAFELIST_STREAM_CHUNK) const;
+    template<class Source>
+    bool load_from(Source&& source);
+
+protected:
+    /*
+        These should never be public. All manipulation should happen through
+        thread safe interfaces; they are protected only so subclasses such as
+        IndexedSafeList can build compound operations on top of them.
+    */
+    bool Lock() const;
+    bool Unlock() const;
+
+    /* Arm one right after Lock() around anything that may throw; see SafeListUnlockGuard. */
+    typedef SafeListUnlockGuard<SafeList> UnlockGuard;
+    friend class SafeListUnlockGuard<SafeList>;
+
+    /*
+        For read-only access. These take the lock shared if LockPolicy
+        supports it and exclusively otherwise. Nothing may be modified under
+        a shared lock, and that includes the stats counters, so a shared
+        hold is not counted in stats().
+    */
+    bool LockShared() const;
+    bool UnlockShared() const;
+
+    /*
+        Bookkeeping for every change to the list. Call with the lock held:
+        Linked() right after count items were added, Unlinking() right before
+        [first, last) is erased or spliced out.
+    */
+    void Linked(size_t count);
+    void Unlinking(typename list<T, Alloc>::const_iterator first, typename list<T, Alloc>::const_iterator last);
+
+    /*
+        Pop helpers; call with the lock held and the list non-empty.
+        RetireFront() splices the front node onto retired for the caller to
+        move from and destroy after Unlock() (see SafeListDeferDestroy).
+        PopFrontLocked() moves the front item into out and frees the node
+        in place.
+    */
+    void RetireFront(list<T, Alloc>& retired);
+    void PopFrontLocked(T& out);
+
+private:
+    /* LockPolicy may be a bare lock policy or a SafeListTraits; see safelisttraits.h. */
+    typedef typename SafeListConfig<T, LockPolicy>::lock_type LockType;
+    typedef typename SafeListConfig<T, LockPolicy>::hooks_type Hooks;
+
+    /* The optional features' state; see SafeListState. */
+    typedef SafeListState<T, Alloc, SafeListConfig<T, LockPolicy>::features> State;
+    typedef typename State::Blocking Blocking;
+    typedef typename State::Bounds Bounds;
+    typedef typename State::Notifier Notifier;
+    typedef typename State::Handles Handles;
+    typedef typename State::Snapshots Snapshots;
+    typedef typename State::Stats Stats;
+
+    template<class... Args>
+    bool EmplaceBack(bool block, const chrono::steady_clock::time_point* deadline, Args&&... args);
+    bool WaitForRoom(bool block, const chrono::steady_clock::time_point* deadline);
+    bool WaitForRoom(bool block, const chrono::steady_clock::time_point* deadline, true_type);
+    bool WaitForRoom(bool block, const chrono::steady_clock::time_point* deadline, false_type);
+    void WaitForItem();
+    bool WaitForItemUntil(const chrono::steady_clock::time_point& deadline);
+    /* Moves all of batch (which must share our allocator) onto the back of the list. */
+    void SpliceBack(list<T, Alloc>& batch);
+
+    /* Splices the items matching pred onto out. Call with the lock held; out must share our allocator. */
+    template<class Predicate>
+    size_t ExtractIf(Predicate& pred, list<T, Alloc>& out);
+
+    /*
+        Helpers for the parallel visits. PartCount() picks how many parts n
+        items are split into. ParallelRun() splits the n items of
+        [first, last) into parts and runs chunk over each. It never throws:
+        the first exception, whether from chunk or from submitting a part to
+        the executor, is returned once every part that was submitted has
+        finished, leaving it to the caller to rethrow once the lock is
+        released.
+    */
+    static size_t PartCount(size_t n, size_t requested);
+    template<class Iterator>
+    static vector<Iterator> PartBounds(Iterator first, Iterator last, size_t n, size_t parts);
+    template<class Executor, class Iterator, class Chunk>
+    static exception_ptr ParallelRun(Executor& executor, Iterator first, Iterator last, size_t n, size_t parts, Chunk& chunk);
+
+    /*
+        Called on unlock and around condition variable waits, i.e. whenever
+        the lock is about to be released or has just been reacquired.
+        HoldEnded() publishes the size for size()/empty() and closes the
+        stats hold interval; HoldStarted() reopens it.
+    */
+    void HoldEnded() const;
+    void HoldStarted() const;
+
+    void LockShared(true_type) const;
+    void LockShared(false_type) const;
+    void UnlockShared(true_type) const;
+    void UnlockShared(false_type) const;
+
+    /*
+        I made these private to help enforce the usage
+        of:
+            push_back(T);
+            pop_front(T);
+
+        instead of:
+
+            list.Lock();
+            list.insert(list.begin(),T);
+            list.Unlock();
+    */
+    typename list<T, Alloc>::iterator begin()
+	{
+		typename list<T, Alloc>::iterator my_itr;
+		Lock();
+		Hooks::trace("begin()");
+		my_itr = list<T, Alloc>::begin();
+		Unlock();
+		return my_itr;
+	} 
+
+
+    typename list<T, Alloc>::iterator end()
+	{
+		typename list<T, Alloc>::iterator my_itr;
+		Lock();
+		Hooks::trace("end()");
+		my_itr = list<T, Alloc>::end();
+		Unlock();
+		return my_itr;
+	}
+    /*
+        Thinking about the design of SafeList iteration. ...it would be irresponsible
+        to simply allow begin() and end() to be used without enforcing some iteration
+        lock. These functions are so common in regular STL usage that it would be
+        extremely easy to have one thread adding or removing elements to the list
+        while another thread is iterating the list. We must be able to guarantee
+        that iteration is protected across threads.
+       
+        However, I'm also worried about simply allowing begin() and end() to be used
+        and relying upon the caller to make sure they properly acquired the lock. We
+        need enforcement via the interface somehow.
+
+        What we need, functionally:
+
+        list.Lock();
+        for(list::iterator itr = list.begin(); itr != list.end(); ++itr)
+        {
+            // do something with *itr
+        }
+        list.Unlock();
+
+        However, we don't want this particular interface layout, primarily because
+        of the commonality of usage of begin() and end(). It would be easy for a
+        programmer to accidentally do:
+
+        list.insert(list.begin(), item);
+
+        Which is inadvisable because the list can change between the calls to
+        list.begin() and list.insert().
+
+        We could do it at runtime by calling TryLock() (or whatever) inside begin()
+        to verify that the lock had previously been acquired and throwing an exeception
+        if it hadn't been, but that's sloppy runtime enforcement. We'd be better served
+        by a more well defined interface that enforces the proper arrangement at compile
+        time.
+
+        We could write a function that takes a lambda/functor and iterates on every item
+        in the list. I'm trying this. see above:
+
+        void visit_all(std::function<bool>(const T& item) visitor);
+    */
+
+
+    bool insert(const typename list<T, Alloc>::const_iterator& itr_arg, const T& t_arg);
+
+
+    typename list<T, Alloc>::iterator erase(const typename list<T, Alloc>::const_iterator& itr_arg)
+	{
+		typename list<T, Alloc>::iterator my_itr;
+		Lock();
+		Hooks::trace("erase(typename list<T>::iterator itr_arg)");
+		Unlinking(itr_arg, std::next(itr_arg));
+		my_itr = list<T, Alloc>::erase( itr_arg );
+		Hooks::trace("erase", list<T, Alloc>::size());
+		Unlock();
+
+		return my_itr;
+	}
+
+    /*
+        Layout: the whole object is cache line aligned so neighbouring lists
+        (in an array or a ShardedSafeList) never share a line. Within it the
+        lock gets a line to itself, away from the std::list head, and the
+        published size is kept apart from both so that threads polling
+        size() don't pull the lock's line away from its holder.
+    */
+    alignas(SAFELIST_CACHE_LINE) mutable LockType safelist_mutex;
+
+    /* The list size as of the last time the lock was released. See size(). */
+    alignas(SAFELIST_CACHE_LINE) mutable atomic<size_t> published_size;
+
+};
+
+template<class T, class LockPolicy, class Alloc>
+SafeList<T, LockPolicy, Alloc>::SafeList()
+    : State(0), published_size(0)
+{
+    Hooks::trace("SafeList()");
+}
+
+template<class T, class LockPolicy, class Alloc>
+SafeList<T, LockPolicy, Alloc>::SafeList(const Alloc& alloc)
+    : list<T, Alloc>(alloc), State(0), published_size(0)
+{
+    Hooks::trace("SafeList(const Alloc&)");
+}
+
+template<class T, class LockPolicy, class Alloc>
+SafeList<T, LockPolicy, Alloc>::SafeList(size_t capacity, const Alloc& alloc)
+    : list<T, Alloc>(alloc), State(capacity), published_size(0)
+{
+    static_assert(Bounds::enabled, "a SafeList with a capacity needs SafeListWithBounds");
+    Hooks::trace("SafeList(size_t capacity)");
+    reserve(capacity);
+}
+
+template<class T, class LockPolicy, class Alloc>
+SafeList<T, LockPolicy, Alloc>::~SafeList()
+{
+    Hooks::trace("~SafeList()");
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::insert(const typename list<T, Alloc>::const_iterator& itr_arg, const T& t_arg)
+{
+    Lock();
+    UnlockGuard guard(*this);
+    Hooks::trace("insert(typename list<T>::iterator itr_arg)");
+    list<T, Alloc>::insert( itr_arg, t_arg );
+    Linked(1);
+    Hooks::trace("insert", list<T, Alloc>::size());
+    guard.unlock();
+    return true;
+}
+
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::Linked(size_t count)
+{
+    Snapshots::Changed();
+    Hooks::linked(count);
+    Stats::Linked(static_cast<const list<T, Alloc>&>(*this), count);
+    Blocking::Linked(count);
+    Notifier::Linked(count, list<T, Alloc>::size());
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::Unlinking(typename list<T, Alloc>::const_iterator first, typename list<T, Alloc>::const_iterator last)
+{
+    Snapshots::Changed();
+    Hooks::unlinking(first, last);
+    Bounds::Unlinking(first, last);
+    Stats::Unlinking(first, last);
+    Handles::Unlinking(static_cast<const list<T, Alloc>&>(*this), first, last);
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::HoldEnded() const
+{
+    /* Skip the store when nothing changed so readers don't dirty the line. */
+    size_t size = list<T, Alloc>::size();
+    if (published_size.load(memory_order_relaxed) != size)
+        published_size.store(size, memory_order_relaxed);
+    Stats::HoldEnded();
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::HoldStarted() const
+{
+    Stats::HoldStarted();
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::set_notifier(SafeListNotifier* new_notifier)
+{
+    static_assert(Notifier::enabled, "set_notifier() needs a SafeList with SafeListWithNotifier");
+    Lock();
+    this->notifier = new_notifier;
+    Unlock();
+}
+
+template<class T, class LockPolicy, class Alloc>
+SafeListStats SafeList<T, LockPolicy, Alloc>::stats() const
+{
+    SafeListStats ret_val;
+    if (Stats::enabled)
+    {
+        Lock();
+        ret_val = Stats::Get();
+        Unlock();
+    }
+    return ret_val;
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::reset_stats()
+{
+    if (Stats::enabled)
+    {
+        Lock();
+        Stats::Reset(list<T, Alloc>::size());
+        Unlock();
+    }
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::Lock() const
+{
+    Hooks::trace("Lock()");
+    Stats::Acquire(safelist_mutex);
+    return true;
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::Unlock() const
+{
+    Hooks::trace("Unlock()");
+    HoldEnded();
+    safelist_mutex.unlock();
+    return true;
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::LockShared() const
+{
+    Hooks::trace("LockShared()");
+    LockShared(integral_constant<bool, SafeListHasSharedLock<LockType>::value>());
+    return true;
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::UnlockShared() const
+{
+    Hooks::trace("UnlockShared()");
+    UnlockShared(integral_constant<bool, SafeListHasSharedLock<LockType>::value>());
+    return true;
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::LockShared(true_type) const
+{
+    safelist_mutex.lock_shared();
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::LockShared(false_type) const
+{
+    Lock();
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::UnlockShared(true_type) const
+{
+    safelist_mutex.unlock_shared();
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::UnlockShared(false_type) const
+{
+    Unlock();
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::empty() const
+{
+    return published_size.load(memory_order_relaxed) == 0;
+}
+
+template<class T, class LockPolicy, class Alloc>
+T SafeList<T, LockPolicy, Alloc>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::RetireFront(list<T, Alloc>& retired)
+{
+    Unlinking(list<T, Alloc>::begin(), std::next(list<T, Alloc>::begin()));
+    retired.splice(retired.end(), *this, list<T, Alloc>::begin());
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::PopFrontLocked(T& out)
+{
+    Unlinking(list<T, Alloc>::begin(), std::next(list<T, Alloc>::begin()));
+    out = std::move(list<T, Alloc>::front());
+    list<T, Alloc>::pop_front();
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::try_pop(T& out)
+{
+    if (SafeListDeferDestroy<T>::value)
+    {
+        list<T, Alloc> retired(list<T, Alloc>::get_allocator());
+        Lock();
+        if(!list<T, Alloc>::empty())
+            RetireFront(retired);
+        Unlock();
+        if (retired.empty())
+            return false;
+        out = std::move(retired.front());
+        return true;
+    }
+
+    bool popped = false;
+    Lock();
+    UnlockGuard guard(*this);
+    if(!list<T, Alloc>::empty())
+    {
+        PopFrontLocked(out);
+        popped = true;
+    }
+    guard.unlock();
+    return popped;
+}
+
+/* Called with the lock held. Waits until the list is non-empty. */
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::WaitForItem()
+{
+    ++this->waiting_consumers;
+    while(list<T, Alloc>::empty())
+    {
+        HoldEnded();
+        this->safelist_cond.wait(safelist_mutex);
+        HoldStarted();
+    }
+    --this->waiting_consumers;
+}
+
+/* Called with the lock held. Returns false if the list is still empty at deadline. */
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::WaitForItemUntil(const chrono::steady_clock::time_point& deadline)
+{
+    ++this->waiting_consumers;
+    while(list<T, Alloc>::empty())
+    {
+        HoldEnded();
+        cv_status status = this->safelist_cond.wait_until(safelist_mutex, deadline);
+        HoldStarted();
+        if (status == cv_status::timeout)
+            break;
+    }
+    --this->waiting_consumers;
+    return !list<T, Alloc>::empty();
+}
+
+template<class T, class LockPolicy, class Alloc>
+T SafeList<T, LockPolicy, Alloc>::wait_pop()
+{
+    static_assert(Blocking::enabled, "wait_pop() needs a SafeList with SafeListWithBlocking");
+    if (SafeListDeferDestroy<T>::value)
+    {
+        list<T, Alloc> retired(list<T, Alloc>::get_allocator());
+        Lock();
+        WaitForItem();
+        RetireFront(retired);
+        Unlock();
+        return std::move(retired.front());
+    }
+
+    T ret_val = T();
+    Lock();
+    UnlockGuard guard(*this);
+    WaitForItem();
+    PopFrontLocked(ret_val);
+    guard.unlock();
+    return ret_val;
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class Rep, class Period>
+T SafeList<T, LockPolicy, Alloc>::wait_pop_for(const chrono::duration<Rep, Period>& timeout)
+{
+    static_assert(Blocking::enabled, "wait_pop_for() needs a SafeList with SafeListWithBlocking");
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(timeout);
+
+    if (SafeListDeferDestroy<T>::value)
+    {
+        list<T, Alloc> retired(list<T, Alloc>::get_allocator());
+        Lock();
+        if (WaitForItemUntil(deadline))
+            RetireFront(retired);
+        Unlock();
+        if (retired.empty())
+            return T();
+        return std::move(retired.front());
+    }
+
+    T ret_val = T();
+    Lock();
+    UnlockGuard guard(*this);
+    if (WaitForItemUntil(deadline))
+        PopFrontLocked(ret_val);
+    guard.unlock();
+    return ret_val;
+}
+
+/*
+    Called with the lock held. Returns true once there is room for one more
+    item, waiting for it if block is set (until *deadline, if given).
+*/
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::WaitForRoom(bool block, const chrono::steady_clock::time_point* deadline)
+{
+    return WaitForRoom(block, deadline, integral_constant<bool, Bounds::enabled>());
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::WaitForRoom(bool block, const chrono::steady_clock::time_point* deadline, true_type)
+{
+    if (!this->max_items)
+        return true;
+    while (list<T, Alloc>::size() >= this->max_items)
+    {
+        if (!block)
+            return false;
+        ++this->waiting_producers;
+        HoldEnded();
+        if (!deadline)
+            this->not_full_cond.wait(safelist_mutex);
+        else if (this->not_full_cond.wait_until(safelist_mutex, *deadline) == cv_status::timeout)
+            block = false;
+        HoldStarted();
+        --this->waiting_producers;
+    }
+    return true;
+}
+
+/* Without SafeListWithBounds there is always room. */
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::WaitForRoom(bool, const chrono::steady_clock::time_point*, false_type)
+{
+    return true;
+}
+
+/*
+    All single item pushes end up here. With a stateless allocator such as
+    std::allocator a blocking push allocates and constructs the node before
+    the lock is taken, and only the splice happens inside the critical
+    section. Stateful allocators (NodePoolAllocator) are cheap enough to
+    call under the lock, and constructing a temporary list with one would
+    cost a reference count round trip per push. Pushes that may fail build
+    the item under the lock so that a failed try_push(T&&) leaves its
+    argument untouched; if that construction or allocation throws, the
+    guard releases the lock on the way out.
+*/
+template<class T, class LockPolicy, class Alloc>
+template<class... Args>
+bool SafeList<T, LockPolicy, Alloc>::EmplaceBack(bool block, const chrono::steady_clock::time_point* deadline, Args&&... args)
+{
+    if (is_empty<Alloc>::value && block && !deadline)
+    {
+        list<T, Alloc> node;
+        node.emplace_back(std::forward<Args>(args)...);
+        Lock();
+        UnlockGuard guard(*this);
+        WaitForRoom(true, NULL);
+        list<T, Alloc>::splice(list<T, Alloc>::end(), node);
+        Linked(1);
+        guard.unlock();
+        return true;
+    }
+
+    Lock();
+    UnlockGuard guard(*this);
+    if (!WaitForRoom(block, deadline))
+    {
+        guard.unlock();
+        return false;
+    }
+    list<T, Alloc>::emplace_back(std::forward<Args>(args)...);
+    Linked(1);
+    guard.unlock();
+    return true;
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::push_back(const T& arg)
+{
+    EmplaceBack(true, NULL, arg);
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::push_back(T&& arg)
+{
+    EmplaceBack(true, NULL, std::move(arg));
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class... Args>
+void SafeList<T, LockPolicy, Alloc>::emplace_back(Args&&... args)
+{
+    EmplaceBack(true, NULL, std::forward<Args>(args)...);
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::try_push(const T& arg)
+{
+    return EmplaceBack(false, NULL, arg);
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::try_push(T&& arg)
+{
+    return EmplaceBack(false, NULL, std::move(arg));
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class Rep, class Period>
+bool SafeList<T, LockPolicy, Alloc>::push_for(const T& arg, const chrono::duration<Rep, Period>& timeout)
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(timeout);
+    return EmplaceBack(true, &deadline, arg);
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class Rep, class Period>
+bool SafeList<T, LockPolicy, Alloc>::push_for(T&& arg, const chrono::duration<Rep, Period>& timeout)
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(timeout);
+    return EmplaceBack(true, &deadline, std::move(arg));
+}
+
+template<class T, class LockPolicy, class Alloc>
+size_t SafeList<T, LockPolicy, Alloc>::capacity() const
+{
+    return Bounds::Limit();
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class InputIt>
+void SafeList<T, LockPolicy, Alloc>::push_back(InputIt first, InputIt last)
+{
+    list<T, Alloc> batch(first, last, list<T, Alloc>::get_allocator());
+    SpliceBack(batch);
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::SpliceBack(list<T, Alloc>& batch)
+{
+    if (batch.empty())
+        return;
+
+    Lock();
+    size_t limit = Bounds::Limit();
+    while (!batch.empty())
+    {
+        /* A bounded list takes the batch in pieces as room frees up. */
+        size_t count = batch.size();
+        typename list<T, Alloc>::iterator last = batch.end();
+        if (limit)
+        {
+            WaitForRoom(true, NULL);
+            if (count > limit - list<T, Alloc>::size())
+            {
+                count = limit - list<T, Alloc>::size();
+                last = std::next(batch.begin(), count);
+            }
+        }
+        list<T, Alloc>::splice(list<T, Alloc>::end(), batch, batch.begin(), last);
+        Linked(count);
+    }
+    Unlock();
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class OutputIt>
+size_t SafeList<T, LockPolicy, Alloc>::pop_front_n(OutputIt out, size_t max)
+{
+    list<T, Alloc> batch(list<T, Alloc>::get_allocator());
+    Lock();
+    typename list<T, Alloc>::iterator last = list<T, Alloc>::begin();
+    size_t count = 0;
+    while (count < max && last != list<T, Alloc>::end())
+    {
+        ++last;
+        ++count;
+    }
+    Unlinking(list<T, Alloc>::begin(), last);
+    batch.splice(batch.begin(), *this, list<T, Alloc>::begin(), last);
+    Unlock();
+
+    for (typename list<T, Alloc>::iterator itr = batch.begin(); itr != batch.end(); ++itr)
+        *out++ = std::move(*itr);
+    return count;
+}
+
+template<class T, class LockPolicy, class Alloc>
+size_t SafeList<T, LockPolicy, Alloc>::drain_into(list<T, Alloc>& out)
+{
+    size_t count;
+    if (out.get_allocator() == list<T, Alloc>::get_allocator())
+    {
+        Lock();
+        count = list<T, Alloc>::size();
+        Unlinking(list<T, Alloc>::begin(), list<T, Alloc>::end());
+        out.splice(out.end(), *this);
+        Unlock();
+        return count;
+    }
+
+    list<T, Alloc> batch(list<T, Alloc>::get_allocator());
+    Lock();
+    count = list<T, Alloc>::size();
+    Unlinking(list<T, Alloc>::begin(), list<T, Alloc>::end());
+    batch.splice(batch.end(), *this);
+    Unlock();
+    for (typename list<T, Alloc>::iterator itr = batch.begin(); itr != batch.end(); ++itr)
+        out.push_back(std::move(*itr));
+    return count;
+}
+
+template<class T, class LockPolicy, class Alloc>
+size_t SafeList<T, LockPolicy, Alloc>::size() const
+{
+    return published_size.load(memory_order_relaxed);
+}
 
-template <class T>
-class SafeList : protected list<T>
+template<class T, class LockPolicy, class Alloc>
+size_t SafeList<T, LockPolicy, Alloc>::size_exact() const
 {
-public:
+    size_t size = 0;
+    LockShared();
+    size = list<T, Alloc>::size();
+    UnlockShared();
+    return size;
+}
 
-    SafeList();
-    virtual ~SafeList();
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::contains(const T& arg) const
+{
+    bool found = false;
+    LockShared();
+    UnlockGuard guard(*this, &SafeList::UnlockShared);
+    for (typename list<T, Alloc>::const_iterator itr = list<T, Alloc>::begin(); itr != list<T, Alloc>::end() && !found; ++itr)
+        found = *itr == arg;
+    guard.unlock();
+    return found;
+}
 
+template<class T, class LockPolicy, class Alloc>
+shared_ptr<const vector<T> > SafeList<T, LockPolicy, Alloc>::snapshot() const
+{
+    shared_ptr<const vector<T> > ret_val;
+    Lock();
+    UnlockGuard guard(*this);
+    ret_val = Snapshots::Cached();
+    if (!ret_val)
+    {
+        ret_val = make_shared<const vector<T> >(list<T, Alloc>::begin(), list<T, Alloc>::end());
+        Snapshots::Cache(ret_val);
+    }
+    guard.unlock();
+    return ret_val;
+}
 
-    bool empty() const;
+template<class T, class LockPolicy, class Alloc>
+template<class Visitor>
+void SafeList<T, LockPolicy, Alloc>::visit_snapshot(Visitor&& visitor) const
+{
+    shared_ptr<const vector<T> > items = snapshot();
+    for (typename vector<T>::const_iterator itr = items->begin(); itr != items->end(); ++itr)
+    {
+        if (!visitor(*itr))
+            break;
+    }
+}
 
-    T pop_front();
-    void push_back(const T& arg);
-    size_t size() const;
-    void remove(const T& arg);
+template<class T, class LockPolicy, class Alloc>
+size_t SafeList<T, LockPolicy, Alloc>::PartCount(size_t n, size_t requested)
+{
+    size_t parts = requested ? requested : thread::hardware_concurrency();
+    size_t max_parts = n / SAFELIST_PARALLEL_MIN_CHUNK;
+    return std::max<size_t>(1, std::min(parts, max_parts));
+}
 
-    /*
-        visit_all
+template<class T, class LockPolicy, class Alloc>
+template<class Iterator>
+vector<Iterator> SafeList<T, LockPolicy, Alloc>::PartBounds(Iterator first, Iterator last, size_t n, size_t parts)
+{
+    vector<Iterator> bounds;
+    bounds.reserve(parts + 1);
+    for (size_t i = 0; i < parts; ++i)
+    {
+        bounds.push_back(first);
+        std::advance(first, n / parts + (i < n % parts ? 1 : 0));
+    }
+    bounds.push_back(last);
+    return bounds;
+}
 
-        Iterate over the list in a thread-safe manner. Your provided
-        visitor is called, passing the item as the argument. Your visitor
-        returns true to continue iterating, or returns false to terminate
-        iteration before reaching the end of the list.
-    */
-    void visit_all(std::function<bool(const T& item)> visitor)
+template<class T, class LockPolicy, class Alloc>
+template<class Executor, class Iterator, class Chunk>
+exception_ptr SafeList<T, LockPolicy, Alloc>::ParallelRun(Executor& executor, Iterator first, Iterator last, size_t n, size_t parts, Chunk& chunk)
+{
+    vector<Iterator> bounds;
+    try
     {
-        Lock();
-        for (typename list<T>::iterator itr = list<T>::begin(); itr != list<T>::end(); ++itr)
+        bounds = PartBounds<Iterator>(first, last, n, PartCount(n, parts));
+    }
+    catch (...)
+    {
+        return current_exception();
+    }
+
+    struct Latch
+    {
+        mutex latch_mutex;
+        condition_variable done;
+        size_t remaining;
+        exception_ptr error;
+    } latch;
+    latch.remaining = bounds.size() - 2;
+
+    /* Parts that never reached the executor are taken off the latch; the ones that did still reference it. */
+    exception_ptr error;
+    size_t i = 1;
+    try
+    {
+        for (; i + 1 < bounds.size(); ++i)
         {
-            if (!visitor(*itr))
-                break;
+            Iterator part_first = bounds[i];
+            Iterator part_last = bounds[i + 1];
+            executor(function<void()>([&latch, &chunk, part_first, part_last]()
+            {
+                exception_ptr error;
+                try
+                {
+                    chunk(part_first, part_last);
+                }
+                catch (...)
+                {
+                    error = current_exception();
+                }
+                lock_guard<mutex> guard(latch.latch_mutex);
+                if (error && !latch.error)
+                    latch.error = error;
+                if (--latch.remaining == 0)
+                    latch.done.notify_all();
+            }));
         }
-        Unlock();
+    }
+    catch (...)
+    {
+        error = current_exception();
+        lock_guard<mutex> guard(latch.latch_mutex);
+        latch.remaining -= bounds.size() - 1 - i;
     }
 
-private:
-    bool MutexInit();
+    if (!error)
+    {
+        try
+        {
+            chunk(bounds[0], bounds[1]);
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+    }
 
-    /* These should be private. All manipulation should happen through thread safe interfaces. */
-    bool Lock() const;
-    bool Unlock() const;
+    unique_lock<mutex> guard(latch.latch_mutex);
+    while (latch.remaining)
+        latch.done.wait(guard);
+    return error ? error : latch.error;
+}
 
-    /*
-        I made these private to help enforce the usage
-        of:
-            push_back(T);
-            pop_front(T);
+template<class T, class LockPolicy, class Alloc>
+template<class Executor, class Visitor>
+void SafeList<T, LockPolicy, Alloc>::parallel_visit(Executor&& executor, Visitor&& visitor, size_t parts) const
+{
+    typedef typename list<T, Alloc>::const_iterator Iterator;
+    atomic<bool> stop(false);
+    auto chunk = [&visitor, &stop](Iterator first, Iterator last)
+    {
+        for (; first != last && !stop.load(memory_order_relaxed); ++first)
+        {
+            if (!visitor(*first))
+                stop.store(true, memory_order_relaxed);
+        }
+    };
 
-        instead of:
+    LockShared();
+    exception_ptr error = ParallelRun(executor, list<T, Alloc>::begin(), list<T, Alloc>::end(), list<T, Alloc>::size(), parts, chunk);
+    UnlockShared();
+    if (error)
+        rethrow_exception(error);
+}
 
-            list.Lock();
-            list.insert(list.begin(),T);
-            list.Unlock();
-    */
-    typename list<T>::iterator begin()
-	{
-		typename list<T>::iterator my_itr;
-		Lock();
-#ifdef SAFELIST_DEBUG
-		cout << "SafeList<T>::begin()" << endl;
-#endif
-		my_itr = list<T>::begin();
-		Unlock();
-		return my_itr;
-	} 
+template<class T, class LockPolicy, class Alloc>
+template<class Executor, class Function>
+void SafeList<T, LockPolicy, Alloc>::parallel_for_each(Executor&& executor, Function&& function, size_t parts)
+{
+    typedef typename list<T, Alloc>::iterator Iterator;
+    auto chunk = [&function](Iterator first, Iterator last)
+    {
+        for (; first != last; ++first)
+            function(*first);
+    };
 
+    Lock();
+    exception_ptr error = ParallelRun(executor, list<T, Alloc>::begin(), list<T, Alloc>::end(), list<T, Alloc>::size(), parts, chunk);
+    Snapshots::Changed();
+    Unlock();
+    if (error)
+        rethrow_exception(error);
+}
 
-    typename list<T>::iterator end()
-	{
-		typename list<T>::iterator my_itr;
-		Lock();
-#ifdef SAFELIST_DEBUG
-		cout << "SafeList<T>::end()" << endl;
-#endif
-		my_itr = list<T>::end();
-		Unlock();
-		return my_itr;
-	}
-    /*
-        Thinking about the design of SafeList iteration. ...it would be irresponsible
-        to simply allow begin() and end() to be used without enforcing some iteration
-        lock. These functions are so common in regular STL usage that it would be
-        extremely easy to have one thread adding or removing elements to the list
-        while another thread is iterating the list. We must be able to guarantee
-        that iteration is protected across threads.
-       
-        However, I'm also worried about simply allowing begin() and end() to be used
-        and relying upon the caller to make sure they properly acquired the lock. We
-        need enforcement via the interface somehow.
+template<class T, class LockPolicy, class Alloc>
+template<class Executor, class Visitor>
+void SafeList<T, LockPolicy, Alloc>::parallel_visit_snapshot(Executor&& executor, Visitor&& visitor, size_t parts) const
+{
+    typedef typename vector<T>::const_iterator Iterator;
+    shared_ptr<const vector<T> > items = snapshot();
+    atomic<bool> stop(false);
+    auto chunk = [&visitor, &stop](Iterator first, Iterator last)
+    {
+        for (; first != last && !stop.load(memory_order_relaxed); ++first)
+        {
+            if (!visitor(*first))
+                stop.store(true, memory_order_relaxed);
+        }
+    };
 
-        What we need, functionally:
+    exception_ptr error = ParallelRun(executor, items->begin(), items->end(), items->size(), parts, chunk);
+    if (error)
+        rethrow_exception(error);
+}
 
-        list.Lock();
-        for(list::iterator itr = list.begin(); itr != list.end(); ++itr)
+template<class T, class LockPolicy, class Alloc>
+template<class Sink>
+bool SafeList<T, LockPolicy, Alloc>::write_to(Sink&& sink, size_t chunk_size) const
+{
+    static_assert(is_trivially_copyable<T>::value, "write_to() needs a trivially copyable T");
+
+    shared_ptr<const vector<T> > items = snapshot();
+    SafeListStreamHeader header = { SAFELIST_STREAM_MAGIC, 1, static_cast<uint32_t>(sizeof(T)), items->size() };
+    const char* data = items->empty() ? NULL : reinterpret_cast<const char*>(&items->front());
+    size_t bytes = items->size() * sizeof(T);
+    if (chunk_size == 0)
+        chunk_size = SAFELIST_STREAM_CHUNK;
+
+    struct iovec iov[SAFELIST_STREAM_IOV];
+    int count = 0;
+    iov[count].iov_base = &header;
+    iov[count].iov_len = sizeof(header);
+    ++count;
+    for (size_t offset = 0; offset < bytes; offset += chunk_size)
+    {
+        iov[count].iov_base = const_cast<char*>(data + offset);
+        iov[count].iov_len = std::min(chunk_size, bytes - offset);
+        if (++count == SAFELIST_STREAM_IOV)
         {
-            // do something with *itr
+            if (!sink(static_cast<const struct iovec*>(iov), count))
+                return false;
+            count = 0;
         }
-        list.Unlock();
+    }
+    return count == 0 || sink(static_cast<const struct iovec*>(iov), count);
+}
 
-        However, we don't want this particular interface layout, primarily because
-        of the commonality of usage of begin() and end(). It would be easy for a
-        programmer to accidentally do:
+template<class T, class LockPolicy, class Alloc>
+template<class Source>
+bool SafeList<T, LockPolicy, Alloc>::load_from(Source&& source)
+{
+    static_assert(is_trivially_copyable<T>::value, "load_from() needs a trivially copyable T");
 
-        list.insert(list.begin(), item);
+    SafeListStreamHeader header;
+    if (source(static_cast<void*>(&header), sizeof(header)) != sizeof(header))
+        return false;
+    if (header.magic != SAFELIST_STREAM_MAGIC || header.version != 1 || header.item_size != sizeof(T))
+        return false;
+    if (header.count == 0)
+        return true;
+    if (header.count > list<T, Alloc>::max_size())
+        return false;
 
-        Which is inadvisable because the list can change between the calls to
-        list.begin() and list.insert().
+    /* Read a chunk at a time so a bogus count fails on a short read rather than on one huge allocation. */
+    size_t remaining = static_cast<size_t>(header.count);
+    size_t per_read = SAFELIST_STREAM_CHUNK / sizeof(T);
+    if (per_read == 0)
+        per_read = 1;
+    vector<T> buffer(std::min(remaining, per_read));
+    list<T, Alloc> batch(list<T, Alloc>::get_allocator());
+    while (remaining)
+    {
+        size_t count = std::min(remaining, buffer.size());
+        size_t bytes = count * sizeof(T);
+        if (source(static_cast<void*>(&buffer.front()), bytes) != bytes)
+            return false;
+        batch.insert(batch.end(), buffer.begin(), buffer.begin() + count);
+        remaining -= count;
+    }
+    SpliceBack(batch);
+    return true;
+}
 
-        We could do it at runtime by calling TryLock() (or whatever) inside begin()
-        to verify that the lock had previously been acquired and throwing an exeception
-        if it hadn't been, but that's sloppy runtime enforcement. We'd be better served
-        by a more well defined interface that enforces the proper arrangement at compile
-        time.
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::reserve(size_t n)
+{
+    SafeListReserve(list<T, Alloc>::get_allocator(), n);
+}
 
-        We could write a function that takes a lambda/functor and iterates on every item
-        in the list. I'm trying this. see above:
+/*
+    Matching items are spliced into a local list rather than erased, which
+    keeps t valid even when it refers to an item in this list.
+*/
+template<class T, class LockPolicy, class Alloc>
+void SafeList<T, LockPolicy, Alloc>::remove(const T& t)
+{
+    remove_if([&t](const T& item) { return item == t; });
+}
 
-        void visit_all(std::function<bool>(const T& item) visitor);
-    */
+template<class T, class LockPolicy, class Alloc>
+template<class Predicate>
+size_t SafeList<T, LockPolicy, Alloc>::ExtractIf(Predicate& pred, list<T, Alloc>& out)
+{
+    size_t count = 0;
+    typename list<T, Alloc>::iterator itr = list<T, Alloc>::begin();
+    while (itr != list<T, Alloc>::end())
+    {
+        typename list<T, Alloc>::iterator next_itr = std::next(itr);
+        if (pred(const_cast<const T&>(*itr)))
+        {
+            Unlinking(itr, next_itr);
+            out.splice(out.end(), *this, itr);
+            ++count;
+        }
+        itr = next_itr;
+    }
+    return count;
+}
 
+template<class T, class LockPolicy, class Alloc>
+template<class Predicate>
+size_t SafeList<T, LockPolicy, Alloc>::remove_if(Predicate&& pred)
+{
+    list<T, Alloc> removed(list<T, Alloc>::get_allocator());
+    Lock();
+    UnlockGuard guard(*this);
+    size_t count = ExtractIf(pred, removed);
+    guard.unlock();
+    return count;
+}
 
-    bool insert(const typename list<T>::const_iterator& itr_arg, const T& t_arg);
+template<class T, class LockPolicy, class Alloc>
+template<class Predicate>
+size_t SafeList<T, LockPolicy, Alloc>::extract_if(Predicate&& pred, list<T, Alloc>& out)
+{
+    size_t count;
+    if (out.get_allocator() == list<T, Alloc>::get_allocator())
+    {
+        Lock();
+        UnlockGuard guard(*this);
+        count = ExtractIf(pred, out);
+        guard.unlock();
+        return count;
+    }
 
+    /* The items matched before a throwing pred still go to out. */
+    list<T, Alloc> batch(list<T, Alloc>::get_allocator());
+    exception_ptr error;
+    Lock();
+    UnlockGuard guard(*this);
+    try
+    {
+        count = ExtractIf(pred, batch);
+    }
+    catch (...)
+    {
+        error = current_exception();
+    }
+    guard.unlock();
+    for (typename list<T, Alloc>::iterator itr = batch.begin(); itr != batch.end(); ++itr)
+        out.push_back(std::move(*itr));
+    if (error)
+        rethrow_exception(error);
+    return count;
+}
 
-    typename list<T>::iterator erase(const typename list<T>::const_iterator& itr_arg)
-	{
-		typename list<T>::iterator my_itr;
-		Lock();
-#ifdef SAFELIST_DEBUG
-		cout << "SafeList<T>::erase(typename list<T>::iterator itr_arg)" << endl;
-#endif
-		my_itr = list<T>::erase( itr_arg );
+template<class T, class LockPolicy, class Alloc>
+SafeListHandle SafeList<T, LockPolicy, Alloc>::push_back_handle(const T& arg)
+{
+    return push_back_handle(T(arg));
+}
 
-#ifdef SAFELIST_DEBUG
-		cout << "\tsize() after erase = " << list<T>::size() << endl;
-#endif
-		Unlock();
+template<class T, class LockPolicy, class Alloc>
+SafeListHandle SafeList<T, LockPolicy, Alloc>::push_back_handle(T&& arg)
+{
+    static_assert(Handles::enabled, "push_back_handle() needs a SafeList with SafeListWithHandles");
+    /* The handle is recorded before the node is spliced in, so a throw leaves the list as it was. */
+    SafeListHandle handle;
+    list<T, Alloc> node(list<T, Alloc>::get_allocator());
+    node.push_back(std::move(arg));
+    Lock();
+    UnlockGuard guard(*this);
+    WaitForRoom(true, NULL);
+    typename list<T, Alloc>::iterator itr = node.begin();
+    handle.node = &*itr;
+    handle.serial = ++this->next_handle_serial;
+    this->handles[handle.node] = typename Handles::HandleEntry(itr, handle.serial);
+    list<T, Alloc>::splice(list<T, Alloc>::end(), node);
+    Linked(1);
+    guard.unlock();
+    return handle;
+}
 
-		return my_itr;
-	}
+template<class T, class LockPolicy, class Alloc>
+bool SafeList<T, LockPolicy, Alloc>::erase(const SafeListHandle& handle)
+{
+    static_assert(Handles::enabled, "erase(handle) needs a SafeList with SafeListWithHandles");
+    list<T, Alloc> removed(list<T, Alloc>::get_allocator());
+    bool erased = false;
+    Lock();
+    typename unordered_map<const void*, typename Handles::HandleEntry>::iterator entry = this->handles.find(handle.node);
+    if (entry != this->handles.end() && entry->second.second == handle.serial)
+    {
+        typename list<T, Alloc>::iterator itr = entry->second.first;
+        Unlinking(itr, std::next(itr));
+        removed.splice(removed.end(), *this, itr);
+        erased = true;
+    }
+    Unlock();
+    return erased;
+}
+
+/*
+    SafeList<T, LockFreePolicy>
+
+    Bounded MPMC queue (Dmitry Vyukov's array queue). Every slot carries a
+    sequence number which tells producers and consumers whether the slot is
+    theirs to fill or drain, so push_back() and pop_front() each cost one CAS
+    on their own position counter and never take a lock or allocate.
+
+    The capacity is fixed at construction and rounded up to a power of 2.
+    push_back() yields until a slot frees up when the ring is full; use
+    try_push() if you would rather find out. T must be default constructible
+    and move assignable. There is no visit_all() or remove() in this mode since
+    there is nothing to lock the ring with while walking it.
+*/
+template <class T>
+class alignas(SAFELIST_CACHE_LINE) SafeList<T, LockFreePolicy>
+{
+public:
+
+    explicit SafeList(size_t capacity = SAFELIST_LOCKFREE_CAPACITY);
+    virtual ~SafeList();
+
+
+    bool empty() const;
 
-    pthread_mutex_t safelist_mutex;
+    T pop_front();
+    bool try_pop(T& out);
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+    bool try_push(const T& arg);
+    bool try_push(T&& arg);
+    size_t size() const;
+    size_t capacity() const;
+
+    /* There is no lock to take here, so this is the same snapshot as size(). */
+    size_t size_exact() const { return size(); }
+
+private:
+    SafeList(const SafeList&);
+    SafeList& operator=(const SafeList&);
+
+    template<class U>
+    bool TryPush(U&& arg);
+
+    struct Cell
+    {
+        atomic<size_t> sequence;
+        T data;
+    };
+
+    /*
+        Producers only write enqueue_pos and consumers only write dequeue_pos,
+        so each gets its own cache line, as does the read-only ring pointer.
+    */
+    alignas(SAFELIST_CACHE_LINE) Cell* cells;
+    size_t mask;
+    alignas(SAFELIST_CACHE_LINE) atomic<size_t> enqueue_pos;
+    alignas(SAFELIST_CACHE_LINE) atomic<size_t> dequeue_pos;
 };
 
 template<class T>
-SafeList<T>::SafeList()
+SafeList<T, LockFreePolicy>::SafeList(size_t capacity) : enqueue_pos(0), dequeue_pos(0)
 {
-      #ifdef SAFELIST_DEBUG
-         cout << "SafeList<T>::SafeList()" << endl;
-#endif
-    MutexInit();
+    size_t slots = 2;
+    while (slots < capacity)
+        slots <<= 1;
+    mask = slots - 1;
+    cells = new Cell[slots];
+    for (size_t i = 0; i < slots; ++i)
+        cells[i].sequence.store(i, memory_order_relaxed);
 }
 
 template<class T>
-SafeList<T>::~SafeList()
+SafeList<T, LockFreePolicy>::~SafeList()
 {
-#ifdef SAFELIST_DEBUG
-         cout << "SafeList<T>::~SafeList()" << endl;
-#endif
-    pthread_mutex_destroy(&safelist_mutex);
+    delete[] cells;
 }
 
 template<class T>
-bool SafeList<T>::insert(const typename list<T>::const_iterator& itr_arg, const T& t_arg)
+template<class U>
+bool SafeList<T, LockFreePolicy>::TryPush(U&& arg)
 {
-    Lock();
-   #ifdef SAFELIST_DEBUG
-        cout << "SafeList<T>::insert(typename list<T>::iterator itr_arg)" << endl;
-        #endif
-    list<T>::insert( itr_arg, t_arg );
-
-    #ifdef SAFELIST_DEBUG
-        cout << "\tsize() after insert = " << list<T>::size() << endl;
-    #endif
-    Unlock();
+    Cell* cell;
+    size_t pos = enqueue_pos.load(memory_order_relaxed);
+    for (;;)
+    {
+        cell = &cells[pos & mask];
+        size_t seq = cell->sequence.load(memory_order_acquire);
+        ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+        if (dif == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+            return false;   /* full */
+        else
+            pos = enqueue_pos.load(memory_order_relaxed);
+    }
+    cell->data = std::forward<U>(arg);
+    cell->sequence.store(pos + 1, memory_order_release);
     return true;
 }
 
-
 template<class T>
-bool SafeList<T>::MutexInit()
+bool SafeList<T, LockFreePolicy>::try_push(const T& arg)
 {
-#ifdef SAFELIST_DEBUG
-    cout << "SafeList<T>::MutexInit()" << endl;
-#endif
-    pthread_mutexattr_t attr;
-    pthread_mutexattr_init( &attr );
-    pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
-    pthread_mutex_init( &safelist_mutex, &attr );
-    pthread_mutexattr_destroy(&attr);
-    return true;
+    return TryPush(arg);
 }
 
 template<class T>
-bool SafeList<T>::Lock() const
+bool SafeList<T, LockFreePolicy>::try_push(T&& arg)
 {
-#ifdef SAFELIST_DEBUG
-         cout << "SafeList<T>::Lock()" << endl;
-#endif
-
-    if ( pthread_mutex_lock( const_cast<pthread_mutex_t*>(&safelist_mutex) ) != 0 )
-        return false;
-    else
-        return true;
+    return TryPush(std::move(arg));
 }
 
 template<class T>
-bool SafeList<T>::Unlock() const
+void SafeList<T, LockFreePolicy>::push_back(const T& arg)
 {
-    #ifdef SAFELIST_DEBUG
-        cout << "SafeList<T>::Unlock()" << endl;
-     #endif
-    if ( pthread_mutex_unlock( const_cast<pthread_mutex_t*>(&safelist_mutex) ) != 0 )
-        return false;
-    else
-        return true;
+    while (!TryPush(arg))
+        this_thread::yield();
 }
 
 template<class T>
-bool SafeList<T>::empty() const
+void SafeList<T, LockFreePolicy>::push_back(T&& arg)
 {
-    return list<T>::empty();
+    /* TryPush() only moves from arg once it owns a slot, so retrying is safe. */
+    while (!TryPush(std::move(arg)))
+        this_thread::yield();
 }
 
 template<class T>
-T SafeList<T>::pop_front()
+bool SafeList<T, LockFreePolicy>::try_pop(T& out)
 {
-    typename list<T>::iterator itr;
-    T ret_val = NULL;
-    Lock();
-    if(!this->empty())
+    Cell* cell;
+    size_t pos = dequeue_pos.load(memory_order_relaxed);
+    for (;;)
     {
-        itr = begin();
-        ret_val = *itr;
-        list<T>::erase(itr);
+        cell = &cells[pos & mask];
+        size_t seq = cell->sequence.load(memory_order_acquire);
+        ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+        if (dif == 0)
+        {
+            if (dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed))
+                break;
+        }
+        else if (dif < 0)
+            return false;   /* empty */
+        else
+            pos = dequeue_pos.load(memory_order_relaxed);
     }
-    Unlock();
+    out = std::move(cell->data);
+    cell->sequence.store(pos + mask + 1, memory_order_release);
+    return true;
+}
+
+template<class T>
+T SafeList<T, LockFreePolicy>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
     return ret_val;
 }
 
+/* size() and empty() are snapshots; they may be stale by the time the caller looks at them. */
 template<class T>
-void SafeList<T>::push_back(const T& arg)
+size_t SafeList<T, LockFreePolicy>::size() const
 {
-    Lock();
-    list<T>::push_back(arg);
-    Unlock();
+    size_t tail = dequeue_pos.load(memory_order_acquire);
+    size_t head = enqueue_pos.load(memory_order_acquire);
+    return head > tail ? head - tail : 0;
 }
 
 template<class T>
-size_t SafeList<T>::size() const
+bool SafeList<T, LockFreePolicy>::empty() const
 {
-    size_t size = 0;
-    Lock();
-    size = list<T>::size();
-    Unlock();
-    return size;
+    return size() == 0;
 }
 
 template<class T>
-void SafeList<T>::remove(const T& t)
+size_t SafeList<T, LockFreePolicy>::capacity() const
 {
-    Lock();
-    list<T>::remove(t);
-    Unlock();
+    return mask + 1;
 }
 
 #endif
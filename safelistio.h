@@ -0,0 +1,161 @@
+/***************************************************************************
+                          safelistio.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFELISTIO_H
+#define SAFELISTIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/* Default bytes per iovec handed to a write_to() sink. */
+#ifndef SAFELIST_STREAM_CHUNK
+#define SAFELIST_STREAM_CHUNK 65536
+#endif
+
+/* Most iovecs handed to a write_to() sink in one call. */
+#ifndef SAFELIST_STREAM_IOV
+#define SAFELIST_STREAM_IOV 16
+#endif
+
+using namespace std;
+
+/*
+    SafeListStreamHeader
+
+    Start of the stream written by SafeList::write_to(): this header, then
+    count items as raw bytes. Everything is in the writer's byte order and
+    layout, so a stream is meant to be read back on the same kind of
+    machine by a build with the same T, which load_from() checks as far as
+    it can through item_size.
+*/
+struct SafeListStreamHeader
+{
+    uint64_t magic;
+    uint32_t version;
+    uint32_t item_size;
+    uint64_t count;
+};
+
+/* "SLSTREAM" when read little endian. */
+#define SAFELIST_STREAM_MAGIC 0x4d4145525453534cULL
+
+/*
+    SafeListFdSink / SafeListFdSource
+
+    A write_to() sink and a load_from() source for a file descriptor, e.g.
+    a socket or a checkpoint file. The sink hands each batch of iovecs to
+    writev(), picking up after partial writes; the source reads until it
+    has what was asked for, end of file or an error.
+*/
+class SafeListFdSink
+{
+public:
+    explicit SafeListFdSink(int fd_arg) : fd(fd_arg) {}
+
+    bool operator()(const struct iovec* iov, int count)
+    {
+        vector<struct iovec> pending(iov, iov + count);
+        size_t first = 0;
+        while (first < pending.size())
+        {
+            ssize_t written = writev(fd, &pending[first], static_cast<int>(pending.size() - first));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            size_t left = static_cast<size_t>(written);
+            while (first < pending.size() && left >= pending[first].iov_len)
+                left -= pending[first++].iov_len;
+            if (left)
+            {
+                pending[first].iov_base = static_cast<char*>(pending[first].iov_base) + left;
+                pending[first].iov_len -= left;
+            }
+        }
+        return true;
+    }
+
+private:
+    int fd;
+};
+
+class SafeListFdSource
+{
+public:
+    explicit SafeListFdSource(int fd_arg) : fd(fd_arg) {}
+
+    size_t operator()(void* buffer, size_t bytes)
+    {
+        size_t done = 0;
+        while (done < bytes)
+        {
+            ssize_t got = read(fd, static_cast<char*>(buffer) + done, bytes - done);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got <= 0)
+                break;
+            done += static_cast<size_t>(got);
+        }
+        return done;
+    }
+
+private:
+    int fd;
+};
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,358 @@
+/***************************************************************************
+                          safelistlock.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFELISTLOCK_H
+#define SAFELISTLOCK_H
+
+#include <pthread.h>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <thread>
+
+using namespace std;
+
+/*
+    Lock policies
+
+    SafeList<T, LockPolicy> guards its list with a LockPolicy object. Any
+    type with lock(), unlock() and try_lock() will do, so std::mutex can be
+    passed directly. The ones below cover the other common trade offs:
+
+        AdaptiveMutexLock   - spins briefly then parks in a non-recursive
+                              pthread mutex (glibc's adaptive mutex where
+                              available). Default.
+        TicketSpinLock      - FIFO fair spinlock. Never sleeps (it yields
+                              once it has spun for a while); only for very
+                              short critical sections with few threads.
+        RecursiveMutexLock  - the original PTHREAD_MUTEX_RECURSIVE lock, for
+                              code that relied on re-entering the list from a
+                              visit_all() visitor.
+        SharedMutexLock     - pthread_rwlock_t. Read-only operations such as
+                              visit_all(), size_exact() and contains() take
+                              it shared, so readers run side by side.
+        WriterPreferringSharedMutexLock
+                            - the same, but a waiting writer holds off new
+                              readers, so pushes and pops can't be starved
+                              by a steady stream of visit_all() calls.
+
+    Any policy that also has lock_shared() and unlock_shared(), such as
+    std::shared_mutex, is used the same way as SharedMutexLock.
+
+    None of the public SafeList entry points re-enter the lock, so the
+    default does not pay for recursion bookkeeping.
+*/
+
+/*
+    SAFELIST_CACHE_LINE
+
+    Alignment used to keep independently written state on separate cache
+    lines. std::hardware_destructive_interference_size is used where the
+    standard library provides it, except under GCC/Clang where its value
+    is tied to -mtune and they warn about using it in headers; there it is
+    64. Define SAFELIST_CACHE_LINE yourself to override (128 is a better
+    choice on CPUs that prefetch cache lines in pairs).
+*/
+#ifndef SAFELIST_CACHE_LINE
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+#define SAFELIST_CACHE_LINE std::hardware_destructive_interference_size
+#else
+#define SAFELIST_CACHE_LINE 64
+#endif
+#endif
+
+/* How long AdaptiveMutexLock (where it spins itself) and TicketSpinLock spin before they park or yield. */
+#ifndef SAFELIST_SPIN_COUNT
+#define SAFELIST_SPIN_COUNT 100
+#endif
+
+inline void SafeListCpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+class RecursiveMutexLock
+{
+public:
+    RecursiveMutexLock()
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init( &attr );
+        pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_RECURSIVE );
+        pthread_mutex_init( &mutex, &attr );
+        pthread_mutexattr_destroy(&attr);
+    }
+    ~RecursiveMutexLock() { pthread_mutex_destroy(&mutex); }
+
+    void lock() { pthread_mutex_lock(&mutex); }
+    void unlock() { pthread_mutex_unlock(&mutex); }
+    bool try_lock() { return pthread_mutex_trylock(&mutex) == 0; }
+
+private:
+    RecursiveMutexLock(const RecursiveMutexLock&);
+    RecursiveMutexLock& operator=(const RecursiveMutexLock&);
+
+    pthread_mutex_t mutex;
+};
+
+/*
+    AdaptiveMutexLock
+
+    On glibc this is a PTHREAD_MUTEX_ADAPTIVE_NP mutex, which spins in
+    the library for a while before it sleeps. Elsewhere it spins itself,
+    test-and-test-and-set style: waiters watch a plain flag that is only
+    written by the holder and only try_lock() once it reads free, so they
+    don't keep stealing the mutex's cache line from the thread that is
+    about to release it.
+*/
+#if defined(__GLIBC__) && defined(__USE_GNU)
+class AdaptiveMutexLock
+{
+public:
+    AdaptiveMutexLock()
+    {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init( &attr );
+        pthread_mutexattr_settype( &attr, PTHREAD_MUTEX_ADAPTIVE_NP );
+        pthread_mutex_init( &mutex, &attr );
+        pthread_mutexattr_destroy(&attr);
+    }
+    ~AdaptiveMutexLock() { pthread_mutex_destroy(&mutex); }
+
+    void lock() { pthread_mutex_lock(&mutex); }
+    void unlock() { pthread_mutex_unlock(&mutex); }
+    bool try_lock() { return pthread_mutex_trylock(&mutex) == 0; }
+
+private:
+    AdaptiveMutexLock(const AdaptiveMutexLock&);
+    AdaptiveMutexLock& operator=(const AdaptiveMutexLock&);
+
+    pthread_mutex_t mutex;
+};
+#else
+class AdaptiveMutexLock
+{
+public:
+    AdaptiveMutexLock() : held(false) { pthread_mutex_init( &mutex, NULL ); }
+    ~AdaptiveMutexLock() { pthread_mutex_destroy(&mutex); }
+
+    void lock()
+    {
+        for (int i = 0; i < SAFELIST_SPIN_COUNT; ++i)
+        {
+            if (!held.load(memory_order_relaxed) && try_lock())
+                return;
+            SafeListCpuRelax();
+        }
+        pthread_mutex_lock(&mutex);
+        held.store(true, memory_order_relaxed);
+    }
+    void unlock()
+    {
+        held.store(false, memory_order_relaxed);
+        pthread_mutex_unlock(&mutex);
+    }
+    bool try_lock()
+    {
+        if (pthread_mutex_trylock(&mutex) != 0)
+            return false;
+        held.store(true, memory_order_relaxed);
+        return true;
+    }
+
+private:
+    AdaptiveMutexLock(const AdaptiveMutexLock&);
+    AdaptiveMutexLock& operator=(const AdaptiveMutexLock&);
+
+    pthread_mutex_t mutex;
+    atomic<bool> held;
+};
+#endif
+
+class TicketSpinLock
+{
+public:
+    TicketSpinLock() : next_ticket(0), now_serving(0) {}
+
+    void lock()
+    {
+        unsigned ticket = next_ticket.fetch_add(1, memory_order_relaxed);
+        for (int spins = 0; now_serving.load(memory_order_acquire) != ticket; ++spins)
+        {
+            /* If the holder got preempted spinning only burns its timeslice. */
+            if (spins < SAFELIST_SPIN_COUNT)
+                SafeListCpuRelax();
+            else
+                this_thread::yield();
+        }
+    }
+    void unlock()
+    {
+        now_serving.store(now_serving.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+    bool try_lock()
+    {
+        unsigned serving = now_serving.load(memory_order_acquire);
+        unsigned expected = serving;
+        return next_ticket.compare_exchange_strong(expected, serving + 1, memory_order_acquire);
+    }
+
+private:
+    TicketSpinLock(const TicketSpinLock&);
+    TicketSpinLock& operator=(const TicketSpinLock&);
+
+    atomic<unsigned> next_ticket;
+    atomic<unsigned> now_serving;
+};
+
+class SharedMutexLock
+{
+public:
+    SharedMutexLock() { Init(false); }
+    ~SharedMutexLock() { pthread_rwlock_destroy(&rwlock); }
+
+    void lock() { pthread_rwlock_wrlock(&rwlock); }
+    void unlock() { pthread_rwlock_unlock(&rwlock); }
+    bool try_lock() { return pthread_rwlock_trywrlock(&rwlock) == 0; }
+
+    void lock_shared() { pthread_rwlock_rdlock(&rwlock); }
+    void unlock_shared() { pthread_rwlock_unlock(&rwlock); }
+    bool try_lock_shared() { return pthread_rwlock_tryrdlock(&rwlock) == 0; }
+
+protected:
+    explicit SharedMutexLock(bool prefer_writers) { Init(prefer_writers); }
+
+private:
+    SharedMutexLock(const SharedMutexLock&);
+    SharedMutexLock& operator=(const SharedMutexLock&);
+
+    /*
+        glibc prefers readers unless told otherwise. Elsewhere there is no
+        portable knob, and most other implementations already favour writers.
+    */
+    void Init(bool prefer_writers)
+    {
+        pthread_rwlockattr_t attr;
+        pthread_rwlockattr_init(&attr);
+#if defined(__GLIBC__) && (defined(__USE_UNIX98) || defined(__USE_XOPEN2K))
+        if (prefer_writers)
+            pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#else
+        (void)prefer_writers;
+#endif
+        pthread_rwlock_init(&rwlock, &attr);
+        pthread_rwlockattr_destroy(&attr);
+    }
+
+    pthread_rwlock_t rwlock;
+};
+
+class WriterPreferringSharedMutexLock : public SharedMutexLock
+{
+public:
+    WriterPreferringSharedMutexLock() : SharedMutexLock(true) {}
+};
+
+/* True for lock policies with lock_shared()/unlock_shared(). */
+template<class LockPolicy>
+struct SafeListHasSharedLock
+{
+    template<class U> static char Test(decltype(&U::lock_shared));
+    template<class U> static long Test(...);
+    static const bool value = sizeof(Test<LockPolicy>(0)) == 1;
+};
+
+/*
+    SafeListUnlockGuard
+
+    Releases a container's lock, which the caller has already taken, when
+    the guard goes out of scope. Arm one right after Lock() wherever user
+    code runs with the lock held (a constructor, an allocation, a
+    predicate or visitor), so an exception can't leave the lock held for
+    good. unlock() releases early and disarms the guard, which is how the
+    normal path ends its critical section. release defaults to
+    Owner::Unlock(); pass &Owner::UnlockShared for a shared hold. Owner
+    must befriend the guard if these are not public.
+*/
+template<class Owner>
+class SafeListUnlockGuard
+{
+public:
+    typedef bool (Owner::*Release)() const;
+
+    explicit SafeListUnlockGuard(const Owner& owner, Release release = &Owner::Unlock)
+        : owner(&owner), release(release) {}
+    ~SafeListUnlockGuard()
+    {
+        if (owner)
+            (owner->*release)();
+    }
+
+    void unlock()
+    {
+        const Owner* locked = owner;
+        owner = NULL;
+        (locked->*release)();
+    }
+
+private:
+    SafeListUnlockGuard(const SafeListUnlockGuard&);
+    SafeListUnlockGuard& operator=(const SafeListUnlockGuard&);
+
+    const Owner* owner;
+    Release release;
+};
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
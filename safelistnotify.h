@@ -0,0 +1,279 @@
+/***************************************************************************
+                          safelistnotify.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFELISTNOTIFY_H
+#define SAFELISTNOTIFY_H
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+
+using namespace std;
+
+/*
+    SafeListNotifier
+
+    Something a SafeList pokes when it goes from empty to non-empty; see
+    SafeList::set_notifier(). notify() is called with the list's lock held,
+    so it must be quick and must not call back into the list.
+*/
+class SafeListNotifier
+{
+public:
+    virtual ~SafeListNotifier() {}
+    virtual void notify() = 0;
+};
+
+/*
+    SafeListEventCount
+
+    Notifier that threads can sleep on. A waiter takes a key with
+    prepare_wait(), checks its condition (e.g. polls its lists) and, if
+    there's still nothing to do, calls wait(key). Any notify() after
+    prepare_wait() makes wait() return straight away, so a push that lands
+    between the check and the sleep is never missed. notify() is a single
+    atomic increment unless somebody is actually asleep.
+
+    On Linux the sleep is a futex on the epoch word. Elsewhere it falls
+    back to a mutex and condition variable.
+*/
+class SafeListEventCount : public SafeListNotifier
+{
+public:
+    SafeListEventCount() : epoch(0), waiters(0) {}
+
+    unsigned prepare_wait()
+    {
+        waiters.fetch_add(1, memory_order_seq_cst);
+        return epoch.load(memory_order_seq_cst);
+    }
+
+    /* Undoes prepare_wait() when the condition turned out to be true. */
+    void cancel_wait()
+    {
+        waiters.fetch_sub(1, memory_order_relaxed);
+    }
+
+    void wait(unsigned key)
+    {
+        while (epoch.load(memory_order_acquire) == key)
+            Sleep(key, NULL);
+        waiters.fetch_sub(1, memory_order_relaxed);
+    }
+
+    /* Returns false if the deadline passed without a notify(). */
+    bool wait_until(unsigned key, const chrono::steady_clock::time_point& deadline)
+    {
+        while (epoch.load(memory_order_acquire) == key)
+        {
+            if (chrono::steady_clock::now() >= deadline)
+            {
+                waiters.fetch_sub(1, memory_order_relaxed);
+                return false;
+            }
+            Sleep(key, &deadline);
+        }
+        waiters.fetch_sub(1, memory_order_relaxed);
+        return true;
+    }
+
+    virtual void notify()
+    {
+        epoch.fetch_add(1, memory_order_seq_cst);
+        if (waiters.load(memory_order_seq_cst) == 0)
+            return;
+#ifdef __linux__
+        syscall(SYS_futex, reinterpret_cast<unsigned*>(&epoch), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#else
+        lock_guard<mutex> guard(sleep_mutex);
+        sleep_cond.notify_all();
+#endif
+    }
+
+private:
+    SafeListEventCount(const SafeListEventCount&);
+    SafeListEventCount& operator=(const SafeListEventCount&);
+
+    /* May return early; the callers recheck epoch. */
+    void Sleep(unsigned key, const chrono::steady_clock::time_point* deadline)
+    {
+#ifdef __linux__
+        struct timespec timeout;
+        if (deadline)
+        {
+            chrono::nanoseconds left = chrono::duration_cast<chrono::nanoseconds>(*deadline - chrono::steady_clock::now());
+            if (left.count() <= 0)
+                return;
+            timeout.tv_sec = static_cast<time_t>(left.count() / 1000000000);
+            timeout.tv_nsec = static_cast<long>(left.count() % 1000000000);
+        }
+        syscall(SYS_futex, reinterpret_cast<unsigned*>(&epoch), FUTEX_WAIT_PRIVATE, key, deadline ? &timeout : NULL, NULL, 0);
+#else
+        unique_lock<mutex> guard(sleep_mutex);
+        if (epoch.load(memory_order_acquire) != key)
+            return;
+        if (deadline)
+            sleep_cond.wait_until(guard, *deadline);
+        else
+            sleep_cond.wait(guard);
+#endif
+    }
+
+    atomic<unsigned> epoch;
+    atomic<unsigned> waiters;
+#ifndef __linux__
+    mutex sleep_mutex;
+    condition_variable sleep_cond;
+#endif
+};
+
+/*
+    SafeListFdNotifier
+
+    Notifier for event loops: fd() becomes readable when the list goes from
+    empty to non-empty, so it can be registered with epoll, poll, select or
+    io_uring. It is an eventfd on Linux and a non-blocking pipe elsewhere.
+    valid() is false if the descriptor could not be created. The list has
+    to be built with SafeListWithNotifier for set_notifier() to exist.
+
+    The descriptor is edge-like: it is only made readable on the empty to
+    non-empty transition, not on every push. When it fires, call clear()
+    first and then pop until the list is empty. A push that races with the
+    drain makes the descriptor readable again, so nothing is lost. A loop
+    that stops popping before the list is empty gets no further wakeups
+    for it until it calls notify() itself.
+*/
+class SafeListFdNotifier : public SafeListNotifier
+{
+public:
+    SafeListFdNotifier() : read_fd(-1), write_fd(-1)
+    {
+#ifdef __linux__
+        read_fd = write_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+        int fds[2];
+        if (pipe(fds) == 0)
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+                fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+            }
+            read_fd = fds[0];
+            write_fd = fds[1];
+        }
+#endif
+    }
+
+    virtual ~SafeListFdNotifier()
+    {
+        if (read_fd >= 0)
+            close(read_fd);
+        if (write_fd >= 0 && write_fd != read_fd)
+            close(write_fd);
+    }
+
+    bool valid() const
+    {
+        return read_fd >= 0;
+    }
+
+    /* The descriptor to wait on for readability. */
+    int fd() const
+    {
+        return read_fd;
+    }
+
+    virtual void notify()
+    {
+        /* A full pipe or saturated eventfd is already readable, so EAGAIN is fine. */
+#ifdef __linux__
+        uint64_t one = 1;
+        ssize_t written = write(write_fd, &one, sizeof(one));
+#else
+        char one = 1;
+        ssize_t written = write(write_fd, &one, sizeof(one));
+#endif
+        (void)written;
+    }
+
+    /* Consumes pending notifications so the descriptor stops being readable. */
+    void clear()
+    {
+        char buffer[64];
+        while (read(read_fd, buffer, sizeof(buffer)) > 0)
+        {
+        }
+    }
+
+private:
+    SafeListFdNotifier(const SafeListFdNotifier&);
+    SafeListFdNotifier& operator=(const SafeListFdNotifier&);
+
+    int read_fd;
+    int write_fd;
+};
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
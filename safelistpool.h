@@ -0,0 +1,324 @@
+/***************************************************************************
+                          safelistpool.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFELISTPOOL_H
+#define SAFELISTPOOL_H
+
+#include "safelistlock.h"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/*
+    SafeListNodePool
+
+    A free list of fixed size blocks carved out of large chunks. Blocks are
+    never returned to the system until the pool is destroyed, so once the
+    pool has grown to the list's high water mark (or been pre-sized with
+    reserve()) allocating and freeing a node is a pointer swap under a
+    spinlock and never reaches malloc.
+
+    The pool has its own lock so nodes can be allocated and freed outside
+    the owning SafeList's lock. The lock is almost never contended since
+    the critical section is two loads and a store.
+
+    A pool given a NUMA node id places its chunks on that node (on Linux,
+    with mbind()), whichever thread happens to grow it. Otherwise chunks
+    come from operator new and land wherever first touch puts them.
+*/
+class SafeListNodePool
+{
+public:
+    SafeListNodePool(size_t block_size, size_t block_align, int numa_node_arg = -1)
+        : free_list(NULL), total_blocks(0), numa_node(numa_node_arg)
+    {
+        if (block_size < sizeof(FreeBlock))
+            block_size = sizeof(FreeBlock);
+        if (block_align < alignof(FreeBlock))
+            block_align = alignof(FreeBlock);
+        stride = (block_size + block_align - 1) / block_align * block_align;
+        align = block_align;
+    }
+
+    ~SafeListNodePool()
+    {
+        for (size_t i = 0; i < chunks.size(); ++i)
+        {
+#ifdef __linux__
+            if (chunks[i].second)
+            {
+                munmap(chunks[i].first, chunks[i].second);
+                continue;
+            }
+#endif
+            ::operator delete(chunks[i].first);
+        }
+    }
+
+    /* True if a block from this pool can hold an object of the given size and alignment. */
+    bool fits(size_t size, size_t alignment) const
+    {
+        return size <= stride && alignment <= align && align <= alignof(max_align_t);
+    }
+
+    void* take()
+    {
+        pool_lock.lock();
+        if (free_list == NULL)
+            GrowLocked(total_blocks < 32 ? 32 : total_blocks);
+        FreeBlock* block = free_list;
+        free_list = block->next;
+        pool_lock.unlock();
+        return block;
+    }
+
+    void give(void* ptr)
+    {
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        pool_lock.lock();
+        block->next = free_list;
+        free_list = block;
+        pool_lock.unlock();
+    }
+
+    /* Make sure the pool holds at least n blocks in total. */
+    void reserve(size_t n)
+    {
+        pool_lock.lock();
+        if (n > total_blocks)
+            GrowLocked(n - total_blocks);
+        pool_lock.unlock();
+    }
+
+    size_t capacity() const { return total_blocks; }
+    int node() const { return numa_node; }
+
+private:
+    SafeListNodePool(const SafeListNodePool&);
+    SafeListNodePool& operator=(const SafeListNodePool&);
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    /* Called with pool_lock held. If growing throws, the lock is released and the pool is unchanged. */
+    void GrowLocked(size_t blocks)
+    {
+        try
+        {
+            Grow(blocks);
+        }
+        catch (...)
+        {
+            pool_lock.unlock();
+            throw;
+        }
+    }
+
+    void Grow(size_t blocks)
+    {
+        /* Make room for the chunk's entry first, so nothing can throw once it exists. */
+        chunks.reserve(chunks.size() + 1);
+        size_t mapped = blocks * stride;
+        char* chunk = NodeChunk(mapped);
+        if (chunk)
+            blocks = mapped / stride;
+        else
+        {
+            chunk = static_cast<char*>(::operator new(blocks * stride));
+            mapped = 0;
+        }
+        chunks.push_back(make_pair(static_cast<void*>(chunk), mapped));
+        for (size_t i = blocks; i > 0; --i)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * stride);
+            block->next = free_list;
+            free_list = block;
+        }
+        total_blocks += blocks;
+    }
+
+    /*
+        Maps whole pages bound (preferably) to numa_node, rounding bytes up
+        to the mapping size. Returns NULL if the pool has no node or the
+        mapping failed, and the caller falls back to operator new.
+    */
+    char* NodeChunk(size_t& bytes)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        if (numa_node < 0)
+            return NULL;
+        size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t mapped = (bytes + page - 1) / page * page;
+        void* chunk = mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (chunk == MAP_FAILED)
+            return NULL;
+        unsigned long mask[16] = { 0 };
+        const unsigned long mask_bits = sizeof(mask) * 8;
+        if (static_cast<unsigned long>(numa_node) < mask_bits)
+        {
+            mask[numa_node / (sizeof(unsigned long) * 8)] |= 1UL << (numa_node % (sizeof(unsigned long) * 8));
+            /* MPOL_PREFERRED: use the node while it has memory, rather than failing. */
+            syscall(SYS_mbind, chunk, mapped, 1, mask, mask_bits, 0);
+        }
+        bytes = mapped;
+        return static_cast<char*>(chunk);
+#else
+        (void)bytes;
+        return NULL;
+#endif
+    }
+
+    TicketSpinLock pool_lock;
+    FreeBlock* free_list;
+    size_t total_blocks;
+    size_t stride;
+    size_t align;
+    int numa_node;
+    /* Each chunk with its mapped size, or 0 if it came from operator new. */
+    vector<pair<void*, size_t> > chunks;
+};
+
+/*
+    NodePoolAllocator
+
+    Allocator that hands single-object allocations out of a
+    SafeListNodePool. Pass it as the third SafeList parameter:
+
+        SafeList<Job*, AdaptiveMutexLock, NodePoolAllocator<Job*> > jobs;
+        jobs.reserve(10000);
+
+    A default constructed allocator creates a new pool sized for a
+    std::list node holding a T (the value plus two link pointers). Copies
+    and rebinds share the same pool, which is what lets the list's node
+    allocator draw from it. Requests the pool can't serve (arrays, larger
+    or over-aligned types) fall through to operator new.
+*/
+template <class T>
+class NodePoolAllocator
+{
+public:
+    typedef T value_type;
+
+    NodePoolAllocator()
+        : pool(make_shared<SafeListNodePool>(sizeof(T) + 2 * sizeof(void*),
+                                             alignof(T) > alignof(void*) ? alignof(T) : alignof(void*)))
+    {
+    }
+
+    /* Same, with the pool's memory placed on the given NUMA node. */
+    explicit NodePoolAllocator(int numa_node)
+        : pool(make_shared<SafeListNodePool>(sizeof(T) + 2 * sizeof(void*),
+                                             alignof(T) > alignof(void*) ? alignof(T) : alignof(void*),
+                                             numa_node))
+    {
+    }
+
+    template <class U>
+    NodePoolAllocator(const NodePoolAllocator<U>& other) : pool(other.pool) {}
+
+    T* allocate(size_t n)
+    {
+        if (n == 1 && pool->fits(sizeof(T), alignof(T)))
+            return static_cast<T*>(pool->take());
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n)
+    {
+        if (n == 1 && pool->fits(sizeof(T), alignof(T)))
+            pool->give(ptr);
+        else
+            ::operator delete(ptr);
+    }
+
+    void reserve(size_t n) { pool->reserve(n); }
+
+    template <class U>
+    bool operator==(const NodePoolAllocator<U>& other) const { return pool == other.pool; }
+    template <class U>
+    bool operator!=(const NodePoolAllocator<U>& other) const { return pool != other.pool; }
+
+private:
+    template <class U> friend class NodePoolAllocator;
+
+    shared_ptr<SafeListNodePool> pool;
+};
+
+/*
+    SafeListReserve
+
+    SafeList<T>::reserve() forwards here. Allocators without a pool have
+    nothing to pre-size, so the default does nothing.
+*/
+template <class Alloc>
+inline void SafeListReserve(const Alloc&, size_t)
+{
+}
+
+template <class T>
+inline void SafeListReserve(NodePoolAllocator<T> alloc, size_t n)
+{
+    alloc.reserve(n);
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
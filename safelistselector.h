@@ -0,0 +1,229 @@
+/***************************************************************************
+                          safelistselector.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFELISTSELECTOR_H
+#define SAFELISTSELECTOR_H
+
+#include "safelist.h"
+#include "safelistnotify.h"
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+/*
+    SafeListSelector
+
+    Waits on several SafeLists at once and pops from whichever has an item,
+    so a dispatcher thread can serve many queues without polling them. Each
+    added list is given the selector's SafeListEventCount as its notifier,
+    which means the dispatcher sleeps while every list is empty and wakes
+    on the first push to any of them.
+
+    Lists are served round robin, taking up to weight items from one list
+    before moving on to the next, so a list with weight 4 gets four times
+    the share of a list with weight 1 while both are busy. An empty list
+    never holds up the others.
+
+    A list can belong to only one selector at a time and must outlive it.
+    The selector is meant to be driven by one dispatcher thread; other
+    threads may keep popping from the lists directly.
+
+    The lists have to be built with SafeListWithNotifier (see
+    safelisttraits.h), which the default LockPolicy turns on:
+
+        typedef SafeListSelector<Job*> Selector;
+        Selector::List high, low;
+*/
+template <class T, class LockPolicy = SafeListTraits<AdaptiveMutexLock, SAFELIST_DEFAULT_FEATURES | SafeListWithNotifier>,
+          class Alloc = typename SafeListConfig<T, LockPolicy>::allocator_type>
+class SafeListSelector
+{
+    static_assert((SafeListConfig<T, LockPolicy>::features & SafeListWithNotifier) != 0,
+                  "SafeListSelector needs lists built with SafeListWithNotifier");
+
+public:
+    typedef SafeList<T, LockPolicy, Alloc> List;
+
+    SafeListSelector();
+    virtual ~SafeListSelector();
+
+
+    /* Returns the index select() reports for items from this list. */
+    size_t add(List& list, unsigned weight = 1);
+    size_t list_count() const;
+
+    /*
+        try_select pops one item without blocking. select() blocks until
+        there is one, select_for() gives up after the timeout. All return
+        false when nothing was popped, and store the index of the list the
+        item came from in *index if index is not NULL.
+    */
+    bool try_select(T& out, size_t* index = NULL);
+    bool select(T& out, size_t* index = NULL);
+    template<class Rep, class Period>
+    bool select_for(T& out, const chrono::duration<Rep, Period>& timeout, size_t* index = NULL);
+
+private:
+    SafeListSelector(const SafeListSelector&);
+    SafeListSelector& operator=(const SafeListSelector&);
+
+    struct Source
+    {
+        List* list;
+        unsigned weight;
+    };
+
+    void Advance();
+
+    vector<Source> sources;
+    size_t cursor;
+    unsigned credit;
+    SafeListEventCount event;
+};
+
+template<class T, class LockPolicy, class Alloc>
+SafeListSelector<T, LockPolicy, Alloc>::SafeListSelector()
+    : cursor(0), credit(0)
+{
+}
+
+template<class T, class LockPolicy, class Alloc>
+SafeListSelector<T, LockPolicy, Alloc>::~SafeListSelector()
+{
+    for (size_t i = 0; i < sources.size(); ++i)
+        sources[i].list->set_notifier(NULL);
+}
+
+template<class T, class LockPolicy, class Alloc>
+size_t SafeListSelector<T, LockPolicy, Alloc>::add(List& list, unsigned weight)
+{
+    Source source;
+    source.list = &list;
+    source.weight = weight ? weight : 1;
+    sources.push_back(source);
+    if (sources.size() == 1)
+        credit = source.weight;
+    list.set_notifier(&event);
+    return sources.size() - 1;
+}
+
+template<class T, class LockPolicy, class Alloc>
+size_t SafeListSelector<T, LockPolicy, Alloc>::list_count() const
+{
+    return sources.size();
+}
+
+template<class T, class LockPolicy, class Alloc>
+void SafeListSelector<T, LockPolicy, Alloc>::Advance()
+{
+    if (++cursor == sources.size())
+        cursor = 0;
+    credit = sources[cursor].weight;
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeListSelector<T, LockPolicy, Alloc>::try_select(T& out, size_t* index)
+{
+    for (size_t tried = 0; tried < sources.size(); ++tried)
+    {
+        size_t from = cursor;
+        bool popped = sources[from].list->try_pop(out);
+        if (!popped || --credit == 0)
+            Advance();
+        if (popped)
+        {
+            if (index)
+                *index = from;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool SafeListSelector<T, LockPolicy, Alloc>::select(T& out, size_t* index)
+{
+    if (sources.empty())
+        return false;
+    for (;;)
+    {
+        unsigned key = event.prepare_wait();
+        if (try_select(out, index))
+        {
+            event.cancel_wait();
+            return true;
+        }
+        event.wait(key);
+    }
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class Rep, class Period>
+bool SafeListSelector<T, LockPolicy, Alloc>::select_for(T& out, const chrono::duration<Rep, Period>& timeout, size_t* index)
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(timeout);
+
+    for (;;)
+    {
+        unsigned key = event.prepare_wait();
+        if (try_select(out, index))
+        {
+            event.cancel_wait();
+            return true;
+        }
+        if (!event.wait_until(key, deadline))
+            return try_select(out, index);
+    }
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,217 @@
+/***************************************************************************
+                          safelisttraits.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFELISTTRAITS_H
+#define SAFELISTTRAITS_H
+
+#include "safelistlock.h"
+#include <cstddef>
+#include <memory>
+
+#ifdef SAFELIST_DEBUG
+#include "safelistdebug.h"
+#endif
+
+using namespace std;
+
+/*
+    Hook policies
+
+    SafeList calls into a hook policy at each of its tracing points: when
+    the list is built and torn down, when the lock is taken and released,
+    and right after items are linked or before they are unlinked. The
+    policy is an empty base of SafeList, so one whose members are all
+    empty inline functions costs neither space nor instructions; that is
+    what SafeListNoHooks is.
+
+    A hook policy must be default constructible and provide the members of
+    SafeListNoHooks below, all const (keep any state mutable). They are
+    called with the list's lock held, except for the constructor and
+    destructor traces, so they must not call back into the list.
+
+        SafeListNoHooks     - does nothing. The default.
+        SafeListDebugHooks  - prints every call to cout, as building with
+                              SAFELIST_DEBUG always has. In
+                              safelistdebug.h, so that nothing else pulls
+                              in <iostream>.
+*/
+struct SafeListNoHooks
+{
+    void trace(const char*) const {}
+    void trace(const char*, size_t) const {}
+    void linked(size_t) const {}
+    template<class Iterator>
+    void unlinking(Iterator, Iterator) const {}
+};
+
+/* What a SafeList gets when nothing else is asked for. SAFELIST_DEBUG still turns tracing on everywhere. */
+#ifdef SAFELIST_DEBUG
+typedef SafeListDebugHooks SafeListDefaultHooks;
+#else
+typedef SafeListNoHooks SafeListDefaultHooks;
+#endif
+
+/*
+    Optional features
+
+    Everything beyond a locked list costs state in every SafeList and
+    work on every push or pop, so a list only has the features its traits
+    ask for; the rest are compiled out, state and all. Combine them with |.
+    Calling something that needs a feature the list was built without is
+    a compile time error that names the flag.
+
+        SafeListWithBlocking    - wait_pop() and wait_pop_for().
+        SafeListWithBounds      - the capacity constructor; push_back()
+                                  then blocks while the list is full.
+                                  Without it try_push() and push_for()
+                                  always succeed and capacity() is 0.
+        SafeListWithNotifier    - set_notifier(), which SafeListSelector
+                                  needs.
+        SafeListWithHandles     - push_back_handle() and erase(handle).
+        SafeListWithSnapshotCache
+                                - snapshot() hands out its last copy again
+                                  while the list is unchanged. Without it
+                                  every snapshot() copies the list.
+        SafeListWithStats       - stats() collects; without it stats()
+                                  returns zeros.
+
+    SAFELIST_DEFAULT_FEATURES is what a SafeList gets when its traits
+    don't say, including when it is given a bare lock policy. It is none
+    of them, except that building with SAFELIST_STATS defined still turns
+    on SafeListWithStats. Define it yourself (say to SafeListWithEverything)
+    to change that for a whole program.
+
+    This is a break for code written when every SafeList had all of
+    these: a plain SafeList<T> no longer has wait_pop(), wait_pop_for(),
+    the capacity constructor, set_notifier(), push_back_handle() or
+    erase(handle), and its snapshot(), visit_snapshot() and write_to()
+    copy the whole list every time. Either name the features in the
+    list's traits, or build with
+    -DSAFELIST_DEFAULT_FEATURES=SafeListWithEverything to get the old
+    behaviour back everywhere at the old cost in size.
+*/
+enum
+{
+    SafeListWithBlocking      = 1 << 0,
+    SafeListWithBounds        = 1 << 1,
+    SafeListWithNotifier      = 1 << 2,
+    SafeListWithHandles       = 1 << 3,
+    SafeListWithSnapshotCache = 1 << 4,
+    SafeListWithStats         = 1 << 5,
+    SafeListWithEverything    = (1 << 6) - 1
+};
+
+#ifndef SAFELIST_DEFAULT_FEATURES
+#ifdef SAFELIST_STATS
+#define SAFELIST_DEFAULT_FEATURES SafeListWithStats
+#else
+#define SAFELIST_DEFAULT_FEATURES 0
+#endif
+#endif
+
+/*
+    SafeListTraits
+
+    Bundles the compile time choices for a SafeList so they can be passed
+    as its second parameter:
+
+        typedef SafeListTraits<TicketSpinLock, SafeListWithBlocking | SafeListWithBounds> Traits;
+        SafeList<Message*, Traits> queue(1000);
+
+    LockPolicy is as described in safelistlock.h, Features as above, Hooks
+    is a hook policy and Allocator is a class template instantiated with
+    the item type. Passing a bare lock policy, as in
+    SafeList<T, TicketSpinLock>, is shorthand for
+    SafeListTraits<TicketSpinLock>. The other containers that take a
+    LockPolicy accept a SafeListTraits in its place too; the ones that are
+    not built on SafeList only use its lock policy.
+*/
+template <class LockPolicy = AdaptiveMutexLock, unsigned Features = SAFELIST_DEFAULT_FEATURES,
+          class Hooks = SafeListDefaultHooks, template<class> class Allocator = allocator>
+struct SafeListTraits
+{
+    typedef LockPolicy lock_policy;
+    typedef Hooks hooks;
+    static const unsigned features = Features;
+
+    template<class T>
+    struct allocator_for
+    {
+        typedef Allocator<T> type;
+    };
+};
+
+/*
+    SafeListConfig
+
+    Resolves the second parameter of a SafeList, whether it is a bare lock
+    policy or a SafeListTraits, into lock_type, features, hooks_type and
+    allocator_type.
+*/
+template <class T, class Config>
+struct SafeListConfig
+{
+    typedef Config lock_type;
+    static const unsigned features = SAFELIST_DEFAULT_FEATURES;
+    typedef SafeListDefaultHooks hooks_type;
+    typedef allocator<T> allocator_type;
+};
+
+template <class T, class LockPolicy, unsigned Features, class Hooks, template<class> class Allocator>
+struct SafeListConfig<T, SafeListTraits<LockPolicy, Features, Hooks, Allocator> >
+{
+    typedef LockPolicy lock_type;
+    static const unsigned features = Features;
+    typedef Hooks hooks_type;
+    typedef typename SafeListTraits<LockPolicy, Features, Hooks, Allocator>::template allocator_for<T>::type allocator_type;
+};
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,296 @@
+/***************************************************************************
+                          safeprioritylist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFEPRIORITYLIST_H
+#define SAFEPRIORITYLIST_H
+
+#include "safelisttraits.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/*
+    SafePriorityList
+
+    Priority-ordered counterpart to SafeList. Items are kept in a binary
+    heap under one lock, so push_back() and pop_front() are O(log n) and
+    pop_front() always returns the item that ranks highest under Compare
+    (with the default less<T>, the largest one, as with priority_queue).
+    Items that compare equal come out in the order they were pushed, so
+    bulk work of one priority stays FIFO while urgent work overtakes it.
+
+    The interface and locking follow SafeRingList. visit_all() walks the
+    heap storage, i.e. every item exactly once but in no particular order.
+*/
+template <class T, class Compare = less<T>, class LockPolicy = AdaptiveMutexLock>
+class alignas(SAFELIST_CACHE_LINE) SafePriorityList
+{
+public:
+
+    explicit SafePriorityList(const Compare& compare = Compare());
+    virtual ~SafePriorityList();
+
+
+    bool empty() const;
+    size_t size() const;
+
+    T pop_front();
+    bool try_pop(T& out);
+    T wait_pop();
+    template<class Rep, class Period>
+    T wait_pop_for(const chrono::duration<Rep, Period>& timeout);
+
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+    template<class... Args>
+    void emplace_back(Args&&... args);
+
+    void reserve(size_t n);
+
+    template<class Visitor>
+    void visit_all(Visitor&& visitor)
+    {
+        Lock();
+        for (typename vector<Entry>::const_iterator it = heap.begin(); it != heap.end(); ++it)
+        {
+            if (!visitor(it->value))
+                break;
+        }
+        Unlock();
+    }
+
+private:
+    SafePriorityList(const SafePriorityList&);
+    SafePriorityList& operator=(const SafePriorityList&);
+
+    struct Entry
+    {
+        T value;
+        unsigned long long serial;
+    };
+
+    /* Heap order: Compare first, then earlier serials rank higher. */
+    struct EntryCompare
+    {
+        explicit EntryCompare(const Compare& c) : compare(c) {}
+        bool operator()(const Entry& a, const Entry& b) const
+        {
+            if (compare(a.value, b.value))
+                return true;
+            if (compare(b.value, a.value))
+                return false;
+            return a.serial > b.serial;
+        }
+        Compare compare;
+    };
+
+    bool Lock() const;
+    bool Unlock() const;
+
+    /* Called with the lock held. */
+    void PopLocked(T& out);
+
+    vector<Entry> heap;
+    EntryCompare entry_compare;
+    unsigned long long next_serial;
+
+    alignas(SAFELIST_CACHE_LINE) mutable typename SafeListConfig<T, LockPolicy>::lock_type heap_mutex;
+    condition_variable_any heap_cond;
+    size_t waiting_consumers;
+};
+
+template<class T, class Compare, class LockPolicy>
+SafePriorityList<T, Compare, LockPolicy>::SafePriorityList(const Compare& compare)
+    : entry_compare(compare), next_serial(0), waiting_consumers(0)
+{
+}
+
+template<class T, class Compare, class LockPolicy>
+SafePriorityList<T, Compare, LockPolicy>::~SafePriorityList()
+{
+}
+
+template<class T, class Compare, class LockPolicy>
+bool SafePriorityList<T, Compare, LockPolicy>::Lock() const
+{
+    heap_mutex.lock();
+    return true;
+}
+
+template<class T, class Compare, class LockPolicy>
+bool SafePriorityList<T, Compare, LockPolicy>::Unlock() const
+{
+    heap_mutex.unlock();
+    return true;
+}
+
+template<class T, class Compare, class LockPolicy>
+void SafePriorityList<T, Compare, LockPolicy>::reserve(size_t n)
+{
+    Lock();
+    heap.reserve(n);
+    Unlock();
+}
+
+template<class T, class Compare, class LockPolicy>
+template<class... Args>
+void SafePriorityList<T, Compare, LockPolicy>::emplace_back(Args&&... args)
+{
+    Entry entry = { T(std::forward<Args>(args)...), 0 };
+    Lock();
+    entry.serial = next_serial++;
+    heap.push_back(std::move(entry));
+    push_heap(heap.begin(), heap.end(), entry_compare);
+    if (waiting_consumers)
+        heap_cond.notify_one();
+    Unlock();
+}
+
+template<class T, class Compare, class LockPolicy>
+void SafePriorityList<T, Compare, LockPolicy>::push_back(const T& arg)
+{
+    emplace_back(arg);
+}
+
+template<class T, class Compare, class LockPolicy>
+void SafePriorityList<T, Compare, LockPolicy>::push_back(T&& arg)
+{
+    emplace_back(std::move(arg));
+}
+
+template<class T, class Compare, class LockPolicy>
+void SafePriorityList<T, Compare, LockPolicy>::PopLocked(T& out)
+{
+    pop_heap(heap.begin(), heap.end(), entry_compare);
+    out = std::move(heap.back().value);
+    heap.pop_back();
+}
+
+template<class T, class Compare, class LockPolicy>
+bool SafePriorityList<T, Compare, LockPolicy>::try_pop(T& out)
+{
+    bool popped = false;
+    Lock();
+    if (!heap.empty())
+    {
+        PopLocked(out);
+        popped = true;
+    }
+    Unlock();
+    return popped;
+}
+
+template<class T, class Compare, class LockPolicy>
+T SafePriorityList<T, Compare, LockPolicy>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T, class Compare, class LockPolicy>
+T SafePriorityList<T, Compare, LockPolicy>::wait_pop()
+{
+    T ret_val = T();
+    Lock();
+    ++waiting_consumers;
+    while (heap.empty())
+        heap_cond.wait(heap_mutex);
+    --waiting_consumers;
+    PopLocked(ret_val);
+    Unlock();
+    return ret_val;
+}
+
+template<class T, class Compare, class LockPolicy>
+template<class Rep, class Period>
+T SafePriorityList<T, Compare, LockPolicy>::wait_pop_for(const chrono::duration<Rep, Period>& timeout)
+{
+    T ret_val = T();
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(timeout);
+
+    Lock();
+    ++waiting_consumers;
+    while (heap.empty())
+    {
+        if (heap_cond.wait_until(heap_mutex, deadline) == cv_status::timeout)
+            break;
+    }
+    --waiting_consumers;
+    if (!heap.empty())
+        PopLocked(ret_val);
+    Unlock();
+    return ret_val;
+}
+
+template<class T, class Compare, class LockPolicy>
+size_t SafePriorityList<T, Compare, LockPolicy>::size() const
+{
+    size_t size = 0;
+    Lock();
+    size = heap.size();
+    Unlock();
+    return size;
+}
+
+template<class T, class Compare, class LockPolicy>
+bool SafePriorityList<T, Compare, LockPolicy>::empty() const
+{
+    return size() == 0;
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
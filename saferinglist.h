@@ -0,0 +1,397 @@
+/***************************************************************************
+                          saferinglist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SAFERINGLIST_H
+#define SAFERINGLIST_H
+
+#include "safelisttraits.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <new>
+#include <utility>
+
+using namespace std;
+
+/*
+    SafeRingList
+
+    FIFO storage alternative to SafeList for code that only ever uses
+    push_back()/pop_front(). Items live in one contiguous ring buffer
+    instead of individually allocated std::list nodes, so there is no
+    per-item allocation or link overhead and visit_all() streams through
+    memory in at most two linear runs.
+
+    The ring doubles when it fills up (under the lock, moving the items
+    across) and never shrinks; call reserve() up front to avoid growing
+    at run time. The interface and locking follow SafeList; there is no
+    insert/erase in the middle, and remove() compacts the ring in one pass.
+*/
+template <class T, class LockPolicy = AdaptiveMutexLock>
+class alignas(SAFELIST_CACHE_LINE) SafeRingList
+{
+public:
+
+    explicit SafeRingList(size_t initial_capacity = 16);
+    virtual ~SafeRingList();
+
+
+    bool empty() const;
+    size_t size() const;
+    size_t capacity() const;
+
+    T pop_front();
+    bool try_pop(T& out);
+    T wait_pop();
+    template<class Rep, class Period>
+    T wait_pop_for(const chrono::duration<Rep, Period>& timeout);
+
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+    template<class... Args>
+    void emplace_back(Args&&... args);
+
+    void remove(const T& arg);
+    void reserve(size_t n);
+
+    /* Same contract as SafeList::visit_all() and SafeList::visit_all_mut(). */
+    template<class Visitor>
+    void visit_all(Visitor&& visitor)
+    {
+        Lock();
+        UnlockGuard guard(*this);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!visitor(const_cast<const T&>(slots[(head + i) & mask])))
+                break;
+        }
+        guard.unlock();
+    }
+
+    template<class Visitor>
+    void visit_all_mut(Visitor&& visitor)
+    {
+        Lock();
+        UnlockGuard guard(*this);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!visitor(slots[(head + i) & mask]))
+                break;
+        }
+        guard.unlock();
+    }
+
+private:
+    SafeRingList(const SafeRingList&);
+    SafeRingList& operator=(const SafeRingList&);
+
+    bool Lock() const;
+    bool Unlock() const;
+
+    typedef SafeListUnlockGuard<SafeRingList> UnlockGuard;
+    friend class SafeListUnlockGuard<SafeRingList>;
+
+    /*
+        Called with the lock held. Grow() leaves the ring as it was if
+        allocating or moving into the new one throws.
+    */
+    void Grow(size_t min_capacity);
+    void PopLocked(T& out);
+    void RemoveLocked(const T& arg);
+
+    T* slots;
+    size_t mask;
+    size_t head;
+    size_t count;
+
+    alignas(SAFELIST_CACHE_LINE) mutable typename SafeListConfig<T, LockPolicy>::lock_type ring_mutex;
+    condition_variable_any ring_cond;
+    size_t waiting_consumers;
+};
+
+template<class T, class LockPolicy>
+SafeRingList<T, LockPolicy>::SafeRingList(size_t initial_capacity)
+    : slots(NULL), mask(0), head(0), count(0), waiting_consumers(0)
+{
+    size_t slot_count = 2;
+    while (slot_count < initial_capacity)
+        slot_count <<= 1;
+    slots = static_cast<T*>(::operator new(slot_count * sizeof(T)));
+    mask = slot_count - 1;
+}
+
+template<class T, class LockPolicy>
+SafeRingList<T, LockPolicy>::~SafeRingList()
+{
+    for (size_t i = 0; i < count; ++i)
+        slots[(head + i) & mask].~T();
+    ::operator delete(slots);
+}
+
+template<class T, class LockPolicy>
+bool SafeRingList<T, LockPolicy>::Lock() const
+{
+    ring_mutex.lock();
+    return true;
+}
+
+template<class T, class LockPolicy>
+bool SafeRingList<T, LockPolicy>::Unlock() const
+{
+    ring_mutex.unlock();
+    return true;
+}
+
+template<class T, class LockPolicy>
+void SafeRingList<T, LockPolicy>::Grow(size_t min_capacity)
+{
+    size_t slot_count = mask + 1;
+    if (min_capacity <= slot_count)
+        return;
+    while (slot_count < min_capacity)
+        slot_count <<= 1;
+
+    T* grown = static_cast<T*>(::operator new(slot_count * sizeof(T)));
+    size_t moved = 0;
+    try
+    {
+        for (; moved < count; ++moved)
+            new (&grown[moved]) T(std::move(slots[(head + moved) & mask]));
+    }
+    catch (...)
+    {
+        while (moved)
+            grown[--moved].~T();
+        ::operator delete(grown);
+        throw;
+    }
+    for (size_t i = 0; i < count; ++i)
+        slots[(head + i) & mask].~T();
+    ::operator delete(slots);
+    slots = grown;
+    mask = slot_count - 1;
+    head = 0;
+}
+
+template<class T, class LockPolicy>
+void SafeRingList<T, LockPolicy>::reserve(size_t n)
+{
+    Lock();
+    UnlockGuard guard(*this);
+    Grow(n);
+    guard.unlock();
+}
+
+template<class T, class LockPolicy>
+template<class... Args>
+void SafeRingList<T, LockPolicy>::emplace_back(Args&&... args)
+{
+    Lock();
+    UnlockGuard guard(*this);
+    if (count == mask + 1)
+        Grow(count * 2);
+    new (&slots[(head + count) & mask]) T(std::forward<Args>(args)...);
+    ++count;
+    if (waiting_consumers)
+        ring_cond.notify_one();
+    guard.unlock();
+}
+
+template<class T, class LockPolicy>
+void SafeRingList<T, LockPolicy>::push_back(const T& arg)
+{
+    emplace_back(arg);
+}
+
+template<class T, class LockPolicy>
+void SafeRingList<T, LockPolicy>::push_back(T&& arg)
+{
+    emplace_back(std::move(arg));
+}
+
+template<class T, class LockPolicy>
+void SafeRingList<T, LockPolicy>::PopLocked(T& out)
+{
+    T& item = slots[head];
+    out = std::move(item);
+    item.~T();
+    head = (head + 1) & mask;
+    --count;
+}
+
+template<class T, class LockPolicy>
+bool SafeRingList<T, LockPolicy>::try_pop(T& out)
+{
+    bool popped = false;
+    Lock();
+    UnlockGuard guard(*this);
+    if (count)
+    {
+        PopLocked(out);
+        popped = true;
+    }
+    guard.unlock();
+    return popped;
+}
+
+template<class T, class LockPolicy>
+T SafeRingList<T, LockPolicy>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T, class LockPolicy>
+T SafeRingList<T, LockPolicy>::wait_pop()
+{
+    T ret_val = T();
+    Lock();
+    UnlockGuard guard(*this);
+    ++waiting_consumers;
+    while (count == 0)
+        ring_cond.wait(ring_mutex);
+    --waiting_consumers;
+    PopLocked(ret_val);
+    guard.unlock();
+    return ret_val;
+}
+
+template<class T, class LockPolicy>
+template<class Rep, class Period>
+T SafeRingList<T, LockPolicy>::wait_pop_for(const chrono::duration<Rep, Period>& timeout)
+{
+    T ret_val = T();
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() +
+        chrono::duration_cast<chrono::steady_clock::duration>(timeout);
+
+    Lock();
+    UnlockGuard guard(*this);
+    ++waiting_consumers;
+    while (count == 0)
+    {
+        if (ring_cond.wait_until(ring_mutex, deadline) == cv_status::timeout)
+            break;
+    }
+    --waiting_consumers;
+    if (count)
+        PopLocked(ret_val);
+    guard.unlock();
+    return ret_val;
+}
+
+/*
+    Compacts the surviving items towards the head in a single pass, all
+    under one hold of the lock. If arg refers to one of our own slots it is
+    copied first, since compaction would otherwise move it out from under
+    the comparison.
+*/
+template<class T, class LockPolicy>
+void SafeRingList<T, LockPolicy>::remove(const T& arg)
+{
+    Lock();
+    UnlockGuard guard(*this);
+    const T* arg_ptr = &arg;
+    if (!less<const T*>()(arg_ptr, slots) && less<const T*>()(arg_ptr, slots + mask + 1))
+    {
+        T value(arg);
+        RemoveLocked(value);
+    }
+    else
+        RemoveLocked(arg);
+    guard.unlock();
+}
+
+template<class T, class LockPolicy>
+void SafeRingList<T, LockPolicy>::RemoveLocked(const T& arg)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        T& item = slots[(head + i) & mask];
+        if (item == arg)
+            continue;
+        if (kept != i)
+            slots[(head + kept) & mask] = std::move(item);
+        ++kept;
+    }
+    for (size_t i = kept; i < count; ++i)
+        slots[(head + i) & mask].~T();
+    count = kept;
+}
+
+template<class T, class LockPolicy>
+size_t SafeRingList<T, LockPolicy>::size() const
+{
+    size_t size = 0;
+    Lock();
+    size = count;
+    Unlock();
+    return size;
+}
+
+template<class T, class LockPolicy>
+bool SafeRingList<T, LockPolicy>::empty() const
+{
+    return size() == 0;
+}
+
+template<class T, class LockPolicy>
+size_t SafeRingList<T, LockPolicy>::capacity() const
+{
+    size_t slot_count = 0;
+    Lock();
+    slot_count = mask + 1;
+    Unlock();
+    return slot_count;
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,233 @@
+/***************************************************************************
+                          shardedsafelist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SHARDEDSAFELIST_H
+#define SHARDEDSAFELIST_H
+
+#include "safelist.h"
+#include <cstdint>
+#include <new>
+
+using namespace std;
+
+/*
+    ShardedSafeList
+
+    N independent SafeList shards behind one interface, for machines where
+    a single safelist_mutex caps throughput. Each thread is given a home
+    shard the first time it touches a ShardedSafeList; producers always push
+    to their home shard, and consumers pop from their home shard first and
+    then steal from the others in turn. Shards are padded so that no two of
+    them share a cache line.
+
+    The price is ordering: items pushed by one thread come out in the order
+    they went in, but there is no FIFO order across threads. size(),
+    empty() and visit_all() walk every shard one at a time, so they see
+    each shard consistently but not all shards at the same instant.
+*/
+template <class T, class LockPolicy = AdaptiveMutexLock, class Alloc = typename SafeListConfig<T, LockPolicy>::allocator_type>
+class ShardedSafeList
+{
+public:
+
+    /* shard_count of 0 means one shard per hardware thread. */
+    explicit ShardedSafeList(size_t shard_count = 0);
+    virtual ~ShardedSafeList();
+
+
+    bool empty() const;
+    size_t size() const;
+    size_t shard_count() const;
+
+    T pop_front();
+    bool try_pop(T& out);
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+
+    /*
+        visit_all
+
+        Visits every shard in turn, locking one shard at a time. Returning
+        false from the visitor stops the walk across all shards.
+    */
+    template<class Visitor>
+    void visit_all(Visitor&& visitor);
+
+private:
+    ShardedSafeList(const ShardedSafeList&);
+    ShardedSafeList& operator=(const ShardedSafeList&);
+
+    size_t HomeShard() const;
+
+    /*
+        SafeList is cache line aligned and padded, so adjacent shards never
+        share a line. The shards are placed by hand because operator new[]
+        only honours over-alignment from C++17 on.
+    */
+    typedef SafeList<T, LockPolicy, Alloc> Shard;
+
+    void* shard_storage;
+    Shard* shards;
+    size_t shards_size;
+};
+
+template<class T, class LockPolicy, class Alloc>
+ShardedSafeList<T, LockPolicy, Alloc>::ShardedSafeList(size_t shard_count)
+{
+    if (shard_count == 0)
+        shard_count = thread::hardware_concurrency();
+    if (shard_count == 0)
+        shard_count = 1;
+    shards_size = shard_count;
+
+    shard_storage = ::operator new(shards_size * sizeof(Shard) + SAFELIST_CACHE_LINE);
+    size_t misalignment = reinterpret_cast<uintptr_t>(shard_storage) % SAFELIST_CACHE_LINE;
+    shards = reinterpret_cast<Shard*>(static_cast<char*>(shard_storage) +
+                                      (misalignment ? SAFELIST_CACHE_LINE - misalignment : 0));
+    for (size_t i = 0; i < shards_size; ++i)
+        new (&shards[i]) Shard();
+}
+
+template<class T, class LockPolicy, class Alloc>
+ShardedSafeList<T, LockPolicy, Alloc>::~ShardedSafeList()
+{
+    for (size_t i = 0; i < shards_size; ++i)
+        shards[i].~Shard();
+    ::operator delete(shard_storage);
+}
+
+/*
+    Threads are numbered round robin as they first show up and keep that
+    number for life, so a thread keeps hitting the same shard (and the same
+    cache lines) instead of hashing somewhere new on every push.
+*/
+template<class T, class LockPolicy, class Alloc>
+size_t ShardedSafeList<T, LockPolicy, Alloc>::HomeShard() const
+{
+    static atomic<size_t> next_thread(0);
+    static thread_local size_t thread_index = next_thread.fetch_add(1, memory_order_relaxed);
+    return thread_index % shards_size;
+}
+
+template<class T, class LockPolicy, class Alloc>
+size_t ShardedSafeList<T, LockPolicy, Alloc>::shard_count() const
+{
+    return shards_size;
+}
+
+template<class T, class LockPolicy, class Alloc>
+void ShardedSafeList<T, LockPolicy, Alloc>::push_back(const T& arg)
+{
+    shards[HomeShard()].push_back(arg);
+}
+
+template<class T, class LockPolicy, class Alloc>
+void ShardedSafeList<T, LockPolicy, Alloc>::push_back(T&& arg)
+{
+    shards[HomeShard()].push_back(std::move(arg));
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool ShardedSafeList<T, LockPolicy, Alloc>::try_pop(T& out)
+{
+    size_t home = HomeShard();
+    for (size_t i = 0; i < shards_size; ++i)
+    {
+        if (shards[(home + i) % shards_size].try_pop(out))
+            return true;
+    }
+    return false;
+}
+
+template<class T, class LockPolicy, class Alloc>
+T ShardedSafeList<T, LockPolicy, Alloc>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T, class LockPolicy, class Alloc>
+size_t ShardedSafeList<T, LockPolicy, Alloc>::size() const
+{
+    size_t total = 0;
+    for (size_t i = 0; i < shards_size; ++i)
+        total += shards[i].size();
+    return total;
+}
+
+template<class T, class LockPolicy, class Alloc>
+bool ShardedSafeList<T, LockPolicy, Alloc>::empty() const
+{
+    for (size_t i = 0; i < shards_size; ++i)
+    {
+        if (!shards[i].empty())
+            return false;
+    }
+    return true;
+}
+
+template<class T, class LockPolicy, class Alloc>
+template<class Visitor>
+void ShardedSafeList<T, LockPolicy, Alloc>::visit_all(Visitor&& visitor)
+{
+    bool keep_going = true;
+    for (size_t i = 0; i < shards_size && keep_going; ++i)
+    {
+        shards[i].visit_all([&](const T& item)
+        {
+            keep_going = visitor(item);
+            return keep_going;
+        });
+    }
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
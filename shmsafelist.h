@@ -0,0 +1,509 @@
+/***************************************************************************
+                          shmsafelist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SHMSAFELIST_H
+#define SHMSAFELIST_H
+
+#include "safelistlock.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+    SharedMemorySafeList
+
+    Bounded FIFO of trivially copyable items in a POSIX shared memory
+    segment, for handing items between processes without sockets. Every
+    process that constructs one with the same name maps the same ring, and
+    the lock and condition variables live in the segment too: a
+    PTHREAD_PROCESS_SHARED, PTHREAD_MUTEX_ROBUST mutex set up the same way
+    RecursiveMutexLock sets up its attributes. An uncontended push or pop
+    is a memcpy between two futex operations that stay in user space, so
+    there is no system call per item.
+
+    The first process to open a name creates and initialises the segment;
+    the others wait for it to be ready. capacity only matters to the
+    creator. The segment outlives the processes until
+    SharedMemorySafeList::unlink() removes the name.
+
+    A creator that fails (a capacity of 0, or ftruncate() or mmap()
+    failing) removes the name again. One that dies before the segment is
+    ready leaves it behind, so an opener that gives up waiting checks
+    whether the creator still holds its flock() on the segment. If not,
+    the segment is abandoned: the opener removes the name and creates the
+    segment afresh. The one case this can't catch is a creator stalled
+    for the whole wait before it even took that lock.
+
+    If a process dies holding the lock, the next process to lock it
+    recovers: every operation finishes by advancing head or tail, so the
+    ring is consistent at any point a process can die, and the mutex is
+    simply marked consistent again. An item that was half written when
+    its producer died is not lost to anyone, because it was never pushed.
+
+    valid() is false if the segment could not be created, opened or was
+    created for a different item size. Link with -lrt on older glibc.
+*/
+template <class T>
+class SharedMemorySafeList
+{
+    static_assert(is_trivially_copyable<T>::value, "SharedMemorySafeList needs a trivially copyable T");
+
+public:
+
+    /* name follows shm_open(): a leading slash and no others, e.g. "/jobs". */
+    SharedMemorySafeList(const char* name, size_t capacity);
+    virtual ~SharedMemorySafeList();
+
+    static bool unlink(const char* name);
+
+
+    bool valid() const;
+    bool empty() const;
+    size_t size() const;
+    size_t capacity() const;
+
+    T pop_front();
+    bool try_pop(T& out);
+    T wait_pop();
+    template<class Rep, class Period>
+    T wait_pop_for(const chrono::duration<Rep, Period>& timeout);
+
+    /* push_back() waits while the ring is full; try_push() returns false instead. */
+    void push_back(const T& arg);
+    bool try_push(const T& arg);
+
+    template<class Visitor>
+    void visit_all(Visitor&& visitor) const
+    {
+        Lock();
+        for (uint64_t pos = header->head; pos != header->tail; ++pos)
+        {
+            if (!visitor(const_cast<const T&>(slots[pos % header->capacity])))
+                break;
+        }
+        Unlock();
+    }
+
+private:
+    SharedMemorySafeList(const SharedMemorySafeList&);
+    SharedMemorySafeList& operator=(const SharedMemorySafeList&);
+
+    /* Everything the processes share. Only offsets and counters, no pointers. */
+    struct Header
+    {
+        atomic<uint32_t> ready;
+        uint32_t version;
+        uint64_t item_size;
+        uint64_t capacity;
+        uint64_t head;
+        uint64_t tail;
+        uint64_t waiting_consumers;
+        uint64_t waiting_producers;
+        pthread_mutex_t mutex;
+        pthread_cond_t not_empty;
+        pthread_cond_t not_full;
+    };
+
+    static size_t SlotsOffset()
+    {
+        size_t align = alignof(T) > SAFELIST_CACHE_LINE ? alignof(T) : SAFELIST_CACHE_LINE;
+        return (sizeof(Header) + align - 1) / align * align;
+    }
+
+    bool Create(int fd, size_t capacity);
+    bool Attach(int fd);
+    bool Reclaim(int fd, const char* name);
+
+    bool Lock() const;
+    bool Unlock() const;
+
+    /* Called with the lock held. Returns false on timeout. */
+    bool Wait(pthread_cond_t* cond, uint64_t* waiting, const struct timespec* deadline) const;
+    void PushLocked(const T& arg);
+    void PopLocked(T& out);
+
+    void* mapping;
+    size_t mapping_size;
+    Header* header;
+    T* slots;
+};
+
+template<class T>
+SharedMemorySafeList<T>::SharedMemorySafeList(const char* name, size_t capacity)
+    : mapping(NULL), mapping_size(0), header(NULL), slots(NULL)
+{
+    /* A second pass only happens after reclaiming a segment whose creator died. */
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        bool ok;
+        bool retry = false;
+        int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0)
+        {
+            /* Held until close(), so openers can tell a slow creator from a dead one. */
+            flock(fd, LOCK_EX);
+            ok = Create(fd, capacity);
+            if (!ok)
+                shm_unlink(name);
+        }
+        else if (errno == EEXIST && (fd = shm_open(name, O_RDWR, 0600)) >= 0)
+        {
+            ok = Attach(fd);
+            if (!ok)
+                retry = Reclaim(fd, name);
+        }
+        else
+            return;
+        close(fd);
+
+        if (ok)
+            return;
+        if (mapping)
+            munmap(mapping, mapping_size);
+        mapping = NULL;
+        header = NULL;
+        if (!retry)
+            return;
+    }
+}
+
+template<class T>
+SharedMemorySafeList<T>::~SharedMemorySafeList()
+{
+    if (mapping)
+        munmap(mapping, mapping_size);
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::unlink(const char* name)
+{
+    return shm_unlink(name) == 0;
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::Create(int fd, size_t capacity)
+{
+    if (capacity == 0)
+        return false;
+    mapping_size = SlotsOffset() + capacity * sizeof(T);
+    if (ftruncate(fd, mapping_size) != 0)
+        return false;
+    mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        mapping = NULL;
+        return false;
+    }
+    header = static_cast<Header*>(mapping);
+    slots = reinterpret_cast<T*>(static_cast<char*>(mapping) + SlotsOffset());
+
+    header->version = 1;
+    header->item_size = sizeof(T);
+    header->capacity = capacity;
+    header->head = 0;
+    header->tail = 0;
+    header->waiting_consumers = 0;
+    header->waiting_producers = 0;
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init( &attr );
+    pthread_mutexattr_setpshared( &attr, PTHREAD_PROCESS_SHARED );
+    pthread_mutexattr_setrobust( &attr, PTHREAD_MUTEX_ROBUST );
+    pthread_mutex_init( &header->mutex, &attr );
+    pthread_mutexattr_destroy(&attr);
+
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&header->not_empty, &cond_attr);
+    pthread_cond_init(&header->not_full, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+
+    /* ftruncate() zero filled the segment, so openers see ready == 0 until now. */
+    header->ready.store(1, memory_order_release);
+    return true;
+}
+
+/* Waits (up to about a second) for the creator to size and initialise the segment. */
+template<class T>
+bool SharedMemorySafeList<T>::Attach(int fd)
+{
+    struct stat info;
+    for (int tries = 0; ; ++tries)
+    {
+        if (fstat(fd, &info) != 0)
+            return false;
+        if (static_cast<size_t>(info.st_size) >= SlotsOffset())
+            break;
+        if (tries == 1000)
+            return false;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    mapping_size = static_cast<size_t>(info.st_size);
+    mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        mapping = NULL;
+        return false;
+    }
+    header = static_cast<Header*>(mapping);
+    slots = reinterpret_cast<T*>(static_cast<char*>(mapping) + SlotsOffset());
+
+    for (int tries = 0; header->ready.load(memory_order_acquire) == 0; ++tries)
+    {
+        if (tries == 1000)
+            return false;
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    return header->version == 1 && header->item_size == sizeof(T) &&
+           SlotsOffset() + header->capacity * sizeof(T) <= mapping_size;
+}
+
+/*
+    Called when Attach() failed. True if the segment never became ready and
+    its creator is gone, in which case the name has been removed (by us,
+    or by another opener that got there first) and can be created again.
+*/
+template<class T>
+bool SharedMemorySafeList<T>::Reclaim(int fd, const char* name)
+{
+    if (header && header->ready.load(memory_order_acquire))
+        return false;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0)
+        return false;
+
+    /* Only remove the name if it still refers to this segment and not to a fresh one. */
+    bool reclaimed = true;
+    int current = shm_open(name, O_RDWR, 0600);
+    if (current >= 0)
+    {
+        struct stat ours;
+        struct stat theirs;
+        if (fstat(fd, &ours) == 0 && fstat(current, &theirs) == 0 &&
+            ours.st_dev == theirs.st_dev && ours.st_ino == theirs.st_ino)
+            reclaimed = shm_unlink(name) == 0;
+        close(current);
+    }
+    flock(fd, LOCK_UN);
+    return reclaimed;
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::Lock() const
+{
+    if (pthread_mutex_lock(&header->mutex) == EOWNERDEAD)
+        pthread_mutex_consistent(&header->mutex);
+    return true;
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::Unlock() const
+{
+    pthread_mutex_unlock(&header->mutex);
+    return true;
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::Wait(pthread_cond_t* cond, uint64_t* waiting, const struct timespec* deadline) const
+{
+    ++*waiting;
+    int status = deadline ? pthread_cond_timedwait(cond, &header->mutex, deadline)
+                          : pthread_cond_wait(cond, &header->mutex);
+    if (status == EOWNERDEAD)
+        pthread_mutex_consistent(&header->mutex);
+    --*waiting;
+    return status != ETIMEDOUT;
+}
+
+template<class T>
+void SharedMemorySafeList<T>::PushLocked(const T& arg)
+{
+    memcpy(&slots[header->tail % header->capacity], &arg, sizeof(T));
+    ++header->tail;
+    if (header->waiting_consumers)
+        pthread_cond_signal(&header->not_empty);
+}
+
+template<class T>
+void SharedMemorySafeList<T>::PopLocked(T& out)
+{
+    memcpy(&out, &slots[header->head % header->capacity], sizeof(T));
+    ++header->head;
+    if (header->waiting_producers)
+        pthread_cond_signal(&header->not_full);
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::try_push(const T& arg)
+{
+    bool pushed = false;
+    Lock();
+    if (header->tail - header->head < header->capacity)
+    {
+        PushLocked(arg);
+        pushed = true;
+    }
+    Unlock();
+    return pushed;
+}
+
+template<class T>
+void SharedMemorySafeList<T>::push_back(const T& arg)
+{
+    Lock();
+    while (header->tail - header->head >= header->capacity)
+        Wait(&header->not_full, &header->waiting_producers, NULL);
+    PushLocked(arg);
+    Unlock();
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::try_pop(T& out)
+{
+    bool popped = false;
+    Lock();
+    if (header->head != header->tail)
+    {
+        PopLocked(out);
+        popped = true;
+    }
+    Unlock();
+    return popped;
+}
+
+template<class T>
+T SharedMemorySafeList<T>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T>
+T SharedMemorySafeList<T>::wait_pop()
+{
+    T ret_val = T();
+    Lock();
+    while (header->head == header->tail)
+        Wait(&header->not_empty, &header->waiting_consumers, NULL);
+    PopLocked(ret_val);
+    Unlock();
+    return ret_val;
+}
+
+template<class T>
+template<class Rep, class Period>
+T SharedMemorySafeList<T>::wait_pop_for(const chrono::duration<Rep, Period>& timeout)
+{
+    T ret_val = T();
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    long long ns = chrono::duration_cast<chrono::nanoseconds>(timeout).count() + deadline.tv_nsec;
+    deadline.tv_sec += static_cast<time_t>(ns / 1000000000);
+    deadline.tv_nsec = static_cast<long>(ns % 1000000000);
+
+    Lock();
+    while (header->head == header->tail)
+    {
+        if (!Wait(&header->not_empty, &header->waiting_consumers, &deadline))
+            break;
+    }
+    if (header->head != header->tail)
+        PopLocked(ret_val);
+    Unlock();
+    return ret_val;
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::valid() const
+{
+    return header != NULL;
+}
+
+template<class T>
+size_t SharedMemorySafeList<T>::size() const
+{
+    size_t size = 0;
+    Lock();
+    size = static_cast<size_t>(header->tail - header->head);
+    Unlock();
+    return size;
+}
+
+template<class T>
+bool SharedMemorySafeList<T>::empty() const
+{
+    return size() == 0;
+}
+
+template<class T>
+size_t SharedMemorySafeList<T>::capacity() const
+{
+    return static_cast<size_t>(header->capacity);
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,244 @@
+/***************************************************************************
+                          spscsafelist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef SPSCSAFELIST_H
+#define SPSCSAFELIST_H
+
+#include "safelistlock.h"
+#include <atomic>
+#include <new>
+#include <thread>
+#include <utility>
+
+using namespace std;
+
+/*
+    SpscSafeList
+
+    Ring buffer for exactly one producer thread and one consumer thread.
+    With only one writer per index no lock or CAS is needed: the producer
+    publishes a slot with a release store of tail and the consumer hands it
+    back with a release store of head, so try_push() and try_pop() are
+    wait-free. Each side also keeps a private copy of the other side's
+    index and only re-reads the shared one when the copy says the ring is
+    full (or empty), which keeps the two cache lines from bouncing on every
+    item.
+
+    The capacity is fixed at construction and rounded up to a power of 2.
+    push_back() yields while the ring is full. visit_all() must only be
+    called from the consumer thread. Calling push_back() from two threads,
+    or pop_front() from two threads, is a bug.
+*/
+template <class T>
+class alignas(SAFELIST_CACHE_LINE) SpscSafeList
+{
+public:
+
+    explicit SpscSafeList(size_t capacity = 1024);
+    virtual ~SpscSafeList();
+
+
+    /* Either side may call these; the answer is only a snapshot. */
+    bool empty() const;
+    size_t size() const;
+    size_t capacity() const;
+
+    /* Producer side. */
+    bool try_push(const T& arg);
+    bool try_push(T&& arg);
+    void push_back(const T& arg);
+    void push_back(T&& arg);
+
+    /* Consumer side. */
+    bool try_pop(T& out);
+    T pop_front();
+
+    template<class Visitor>
+    void visit_all(Visitor&& visitor)
+    {
+        size_t first = head.load(memory_order_relaxed);
+        size_t last = tail.load(memory_order_acquire);
+        for (size_t pos = first; pos != last; ++pos)
+        {
+            if (!visitor(const_cast<const T&>(slots[pos & mask])))
+                break;
+        }
+    }
+
+private:
+    SpscSafeList(const SpscSafeList&);
+    SpscSafeList& operator=(const SpscSafeList&);
+
+    template<class U>
+    bool TryPush(U&& arg);
+
+    /* Read only after construction. */
+    alignas(SAFELIST_CACHE_LINE) T* slots;
+    size_t mask;
+
+    /* Written by the producer. */
+    alignas(SAFELIST_CACHE_LINE) atomic<size_t> tail;
+    size_t cached_head;
+
+    /* Written by the consumer. */
+    alignas(SAFELIST_CACHE_LINE) atomic<size_t> head;
+    size_t cached_tail;
+};
+
+template<class T>
+SpscSafeList<T>::SpscSafeList(size_t capacity)
+    : tail(0), cached_head(0), head(0), cached_tail(0)
+{
+    size_t slot_count = 2;
+    while (slot_count < capacity)
+        slot_count <<= 1;
+    slots = static_cast<T*>(::operator new(slot_count * sizeof(T)));
+    mask = slot_count - 1;
+}
+
+template<class T>
+SpscSafeList<T>::~SpscSafeList()
+{
+    size_t last = tail.load(memory_order_relaxed);
+    for (size_t pos = head.load(memory_order_relaxed); pos != last; ++pos)
+        slots[pos & mask].~T();
+    ::operator delete(slots);
+}
+
+template<class T>
+template<class U>
+bool SpscSafeList<T>::TryPush(U&& arg)
+{
+    size_t pos = tail.load(memory_order_relaxed);
+    if (pos - cached_head > mask)
+    {
+        cached_head = head.load(memory_order_acquire);
+        if (pos - cached_head > mask)
+            return false;
+    }
+    new (&slots[pos & mask]) T(std::forward<U>(arg));
+    tail.store(pos + 1, memory_order_release);
+    return true;
+}
+
+template<class T>
+bool SpscSafeList<T>::try_push(const T& arg)
+{
+    return TryPush(arg);
+}
+
+template<class T>
+bool SpscSafeList<T>::try_push(T&& arg)
+{
+    return TryPush(std::move(arg));
+}
+
+template<class T>
+void SpscSafeList<T>::push_back(const T& arg)
+{
+    while (!TryPush(arg))
+        this_thread::yield();
+}
+
+template<class T>
+void SpscSafeList<T>::push_back(T&& arg)
+{
+    /* TryPush() only moves from arg once it has a free slot, so retrying is safe. */
+    while (!TryPush(std::move(arg)))
+        this_thread::yield();
+}
+
+template<class T>
+bool SpscSafeList<T>::try_pop(T& out)
+{
+    size_t pos = head.load(memory_order_relaxed);
+    if (pos == cached_tail)
+    {
+        cached_tail = tail.load(memory_order_acquire);
+        if (pos == cached_tail)
+            return false;
+    }
+    T& item = slots[pos & mask];
+    out = std::move(item);
+    item.~T();
+    head.store(pos + 1, memory_order_release);
+    return true;
+}
+
+template<class T>
+T SpscSafeList<T>::pop_front()
+{
+    T ret_val = T();
+    try_pop(ret_val);
+    return ret_val;
+}
+
+template<class T>
+size_t SpscSafeList<T>::size() const
+{
+    size_t first = head.load(memory_order_acquire);
+    size_t last = tail.load(memory_order_acquire);
+    return last > first ? last - first : 0;
+}
+
+template<class T>
+bool SpscSafeList<T>::empty() const
+{
+    return size() == 0;
+}
+
+template<class T>
+size_t SpscSafeList<T>::capacity() const
+{
+    return mask + 1;
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
@@ -0,0 +1,1091 @@
+/***************************************************************************
+                          safelist_test.cpp  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+/*
+    SafeList behaviour tests
+
+    Stand-alone test driver with no dependencies beyond the headers in this
+    repository, the correctness counterpart to bench/safelist_bench.cpp.
+    Build it the same way, for example:
+
+        g++ -std=c++11 -O2 -pthread -I.. safelist_test.cpp -o safelist_test
+
+    (add -lrt on older glibc) and run it with:
+
+        ./safelist_test [--filter text]
+
+    Each suite prints the checks that failed, if any, then "name ok" or
+    "name FAILED", and the driver exits with status 1 if any check
+    failed, so a build step can run it.
+    Suites that need a file or a shared memory segment create them under
+    /tmp and /dev/shm with the process id in the name and remove them
+    again.
+*/
+
+#include "safelist.h"
+#include "safelistpool.h"
+#include "safelistselector.h"
+#include "safelistnotify.h"
+#include "indexedsafelist.h"
+#include "shardedsafelist.h"
+#include "saferinglist.h"
+#include "spscsafelist.h"
+#include "safeprioritylist.h"
+#include "workstealinglist.h"
+#include "numasafelist.h"
+#include "mappedsafelist.h"
+#include "shmsafelist.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+namespace
+{
+
+string filter;
+int failures = 0;
+int suite_failures = 0;
+
+#define CHECK(condition) Check((condition), #condition, __LINE__)
+
+void Check(bool passed, const char* what, int line)
+{
+    if (passed)
+        return;
+    printf("    line %d: CHECK(%s) failed\n", line, what);
+    ++suite_failures;
+}
+
+typedef chrono::steady_clock Clock;
+
+long ElapsedMs(Clock::time_point start)
+{
+    return (long)chrono::duration_cast<chrono::milliseconds>(Clock::now() - start).count();
+}
+
+/* An executor for the parallel visits that runs every part on its own thread. */
+struct ThreadExecutor
+{
+    ThreadExecutor(vector<thread>& threads_arg) : threads(&threads_arg) {}
+    void operator()(const function<void()>& part) { threads->push_back(thread(part)); }
+    vector<thread>* threads;
+};
+
+/* Counts live instances and can be told to throw from its constructor or copy. */
+struct Tracked
+{
+    static int live;
+    static int throw_on;
+
+    explicit Tracked(int value_arg = 0) : value(value_arg)
+    {
+        if (value == throw_on)
+            throw runtime_error("constructor");
+        ++live;
+    }
+    Tracked(const Tracked& other) : value(other.value)
+    {
+        if (value == throw_on)
+            throw runtime_error("copy");
+        ++live;
+    }
+    Tracked(Tracked&& other) : value(other.value) { ++live; }
+    Tracked& operator=(const Tracked& other) { value = other.value; return *this; }
+    Tracked& operator=(Tracked&& other) { value = other.value; return *this; }
+    ~Tracked() { --live; }
+    bool operator==(const Tracked& other) const { return value == other.value; }
+
+    int value;
+};
+
+int Tracked::live = 0;
+int Tracked::throw_on = -1;
+
+struct Pod
+{
+    int id;
+    float weight;
+};
+
+void BlockingSuite()
+{
+    SafeList<int, SafeListTraits<AdaptiveMutexLock, SafeListWithBlocking> > list;
+
+    Clock::time_point start = Clock::now();
+    CHECK(list.wait_pop_for(chrono::milliseconds(50)) == 0);
+    CHECK(ElapsedMs(start) >= 45);
+
+    thread producer([&]() { this_thread::sleep_for(chrono::milliseconds(20)); list.push_back(7); });
+    CHECK(list.wait_pop() == 7);
+    producer.join();
+
+    thread late([&]() { this_thread::sleep_for(chrono::milliseconds(20)); list.push_back(8); });
+    CHECK(list.wait_pop_for(chrono::seconds(10)) == 8);
+    late.join();
+}
+
+void LockFreeSuite()
+{
+    SafeList<int, LockFreePolicy> ring(5);
+    CHECK(ring.capacity() == 8);
+    for (int i = 0; i < 8; ++i)
+        CHECK(ring.try_push(i));
+    CHECK(!ring.try_push(8));
+    int item = -1;
+    CHECK(ring.try_pop(item) && item == 0);
+
+    SafeList<long, LockFreePolicy> queue(64);
+    atomic<long> sum(0);
+    vector<thread> threads;
+    for (int p = 0; p < 2; ++p)
+        threads.push_back(thread([&]() { for (long i = 1; i <= 10000; ++i) queue.push_back(i); }));
+    for (int c = 0; c < 2; ++c)
+        threads.push_back(thread([&]()
+        {
+            for (long got = 0; got < 10000; )
+            {
+                long value;
+                if (queue.try_pop(value))
+                {
+                    sum += value;
+                    ++got;
+                }
+                else
+                    this_thread::yield();
+            }
+        }));
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    CHECK(sum == 2 * 10000L * 10001 / 2);
+    CHECK(queue.empty());
+}
+
+void BatchSuite()
+{
+    SafeList<int> queue;
+    vector<int> items;
+    for (int i = 0; i < 10; ++i)
+        items.push_back(i);
+    queue.push_back(items.begin(), items.end());
+    CHECK(queue.size() == 10);
+
+    vector<int> out;
+    CHECK(queue.pop_front_n(back_inserter(out), 4) == 4);
+    CHECK(out.size() == 4 && out[0] == 0 && out[3] == 3);
+
+    list<int> drained;
+    CHECK(queue.drain_into(drained) == 6);
+    CHECK(drained.front() == 4 && drained.back() == 9 && queue.empty());
+}
+
+void LockPolicySuite()
+{
+    SafeList<int, TicketSpinLock> ticket;
+    SafeList<int, std::mutex> std_mutex;
+    SafeList<int, AdaptiveMutexLock> adaptive;
+    vector<thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.push_back(thread([&]()
+        {
+            for (int i = 0; i < 2000; ++i)
+            {
+                ticket.push_back(i);
+                std_mutex.push_back(i);
+                adaptive.push_back(i);
+            }
+        }));
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    CHECK(ticket.size_exact() == 8000 && std_mutex.size_exact() == 8000 && adaptive.size_exact() == 8000);
+
+    /* Only the recursive policy lets a visitor call back into its list. */
+    SafeList<int, RecursiveMutexLock> recursive;
+    recursive.push_back(1);
+    size_t seen = 0;
+    recursive.visit_all([&](const int&) { seen = recursive.size_exact(); return true; });
+    CHECK(seen == 1);
+}
+
+void MoveSuite()
+{
+    SafeList<unique_ptr<int> > list;
+    list.push_back(unique_ptr<int>(new int(1)));
+    list.emplace_back(new int(2));
+    unique_ptr<int> out;
+    CHECK(list.try_pop(out) && *out == 1);
+    CHECK(list.try_pop(out) && *out == 2);
+    CHECK(!list.try_pop(out));
+
+    /* try_push() copies under the lock; a throwing copy must not leave it held. */
+    {
+        SafeList<Tracked, SafeListTraits<AdaptiveMutexLock, SafeListWithBounds> > bounded(4);
+        Tracked item(13);
+        Tracked::throw_on = 13;
+        bool threw = false;
+        try
+        {
+            bounded.try_push(item);
+        }
+        catch (const runtime_error&)
+        {
+            threw = true;
+        }
+        Tracked::throw_on = -1;
+        CHECK(threw);
+        CHECK(bounded.try_push(Tracked(1)) && bounded.size_exact() == 1);
+    }
+    CHECK(Tracked::live == 0);
+}
+
+void PoolSuite()
+{
+    SafeList<int, AdaptiveMutexLock, NodePoolAllocator<int> > list;
+    list.reserve(100);
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 100; ++i)
+            list.push_back(i);
+        int item;
+        while (list.try_pop(item))
+            ;
+    }
+    CHECK(list.empty());
+}
+
+void ShardedSuite()
+{
+    ShardedSafeList<int> list(4);
+    CHECK(list.shard_count() == 4);
+    long sum = 0;
+    for (int i = 0; i < 1000; ++i)
+        list.push_back(i);
+    CHECK(list.size() == 1000);
+    int item;
+    while (list.try_pop(item))
+        sum += item;
+    CHECK(sum == 999L * 1000 / 2 && list.empty());
+}
+
+void SnapshotSuite()
+{
+    SafeList<int, SafeListTraits<AdaptiveMutexLock, SafeListWithSnapshotCache> > list;
+    for (int i = 0; i < 5; ++i)
+        list.push_back(i);
+
+    shared_ptr<const vector<int> > first = list.snapshot();
+    CHECK(list.snapshot() == first);
+    list.push_back(5);
+    CHECK(first->size() == 5);
+    shared_ptr<const vector<int> > second = list.snapshot();
+    CHECK(second != first && second->size() == 6);
+
+    size_t visited = 0;
+    list.visit_snapshot([&](const int&) { ++visited; list.push_back(0); return true; });
+    CHECK(visited == 6 && list.size() == 12);
+
+    /* Only a weak reference is kept, so a dropped snapshot is not reused. */
+    weak_ptr<const vector<int> > dropped = list.snapshot();
+    CHECK(dropped.expired());
+}
+
+void VisitorSuite()
+{
+    SafeList<int, SharedMutexLock> list;
+    for (int i = 0; i < 10; ++i)
+        list.push_back(i);
+
+    int visited = 0;
+    list.visit_all([&](const int& item) { ++visited; return item < 4; });
+    CHECK(visited == 5);
+
+    list.visit_all_mut([](int& item) { item *= 2; return true; });
+    CHECK(list.contains(18) && !list.contains(9));
+
+    bool threw = false;
+    try
+    {
+        list.visit_all([](const int& item) -> bool { if (item == 6) throw runtime_error("visitor"); return true; });
+    }
+    catch (const runtime_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    list.push_back(1);
+    CHECK(list.size_exact() == 11);
+}
+
+void HandleSuite()
+{
+    SafeList<int, SafeListTraits<AdaptiveMutexLock, SafeListWithHandles> > list;
+    SafeListHandle first = list.push_back_handle(1);
+    SafeListHandle second = list.push_back_handle(2);
+    list.push_back(3);
+
+    CHECK(list.erase(second));
+    CHECK(!list.erase(second));
+    int item;
+    CHECK(list.try_pop(item) && item == 1);
+    CHECK(!list.erase(first));
+
+    /* A new item in a recycled node must not answer to the old handle. */
+    SafeListHandle reused = list.push_back_handle(4);
+    CHECK(!list.erase(first) && list.erase(reused));
+    CHECK(!list.erase(SafeListHandle()));
+    CHECK(list.size_exact() == 1);
+
+    IndexedSafeList<int> indexed;
+    for (int i = 0; i < 6; ++i)
+        indexed.push_back(i % 3);
+    CHECK(indexed.contains(2));
+    indexed.remove(2);
+    CHECK(!indexed.contains(2) && indexed.size() == 4);
+    CHECK(indexed.try_pop(item) && item == 0);
+}
+
+void RingSuite()
+{
+    SafeRingList<string> ring(2);
+    for (int i = 0; i < 20; ++i)
+        ring.push_back(to_string(i));
+    CHECK(ring.size() == 20 && ring.capacity() >= 20);
+    string item;
+    CHECK(ring.try_pop(item) && item == "0");
+
+    /* remove() with an argument that lives in the ring itself. */
+    ring.push_back("1");
+    string* resident = NULL;
+    ring.visit_all_mut([&](string& value) { resident = &value; return false; });
+    ring.remove(*resident);
+    CHECK(ring.size() == 18);
+    CHECK(ring.try_pop(item) && item == "2");
+
+    SafeRingList<int> timed;
+    Clock::time_point start = Clock::now();
+    CHECK(timed.wait_pop_for(chrono::milliseconds(30)) == 0 && ElapsedMs(start) >= 25);
+}
+
+void BoundedSuite()
+{
+    typedef SafeList<int, SafeListTraits<AdaptiveMutexLock, SafeListWithBounds> > Bounded;
+    Bounded list(2);
+    CHECK(list.capacity() == 2);
+    CHECK(list.try_push(1) && list.try_push(2));
+    CHECK(!list.try_push(3));
+
+    Clock::time_point start = Clock::now();
+    CHECK(!list.push_for(3, chrono::milliseconds(40)));
+    CHECK(ElapsedMs(start) >= 35 && list.size_exact() == 2);
+
+    /* A blocked push goes through once a consumer makes room. */
+    thread consumer([&]() { this_thread::sleep_for(chrono::milliseconds(20)); list.pop_front(); });
+    list.push_back(3);
+    consumer.join();
+    CHECK(list.size_exact() == 2);
+
+    /* A range longer than the capacity goes in as room frees up. */
+    Bounded ranged(2);
+    int items[] = { 1, 2, 3, 4, 5 };
+    thread drain([&]()
+    {
+        for (int got = 0; got < 5; )
+        {
+            int item;
+            if (ranged.try_pop(item))
+                ++got;
+            else
+                this_thread::yield();
+        }
+    });
+    ranged.push_back(items, items + 5);
+    drain.join();
+    CHECK(ranged.size_exact() == 0);
+
+    SafeList<int> unbounded;
+    CHECK(unbounded.capacity() == 0 && unbounded.try_push(1));
+}
+
+void StatsSuite()
+{
+    SafeList<int, SafeListTraits<AdaptiveMutexLock, SafeListWithStats> > list;
+    for (int i = 0; i < SAFELIST_STATS_SAMPLE_RATE * 4; ++i)
+        list.push_back(i);
+    int item;
+    while (list.try_pop(item))
+        ;
+    SafeListStats stats = list.stats();
+    CHECK(stats.pushes == SAFELIST_STATS_SAMPLE_RATE * 4 && stats.pops == stats.pushes);
+    CHECK(stats.high_water == SAFELIST_STATS_SAMPLE_RATE * 4);
+    CHECK(stats.latency_samples == 4);
+    CHECK(stats.lock_acquisitions >= stats.pushes);
+    list.reset_stats();
+    CHECK(list.stats().pushes == 0);
+
+    SafeList<int> plain;
+    plain.push_back(1);
+    CHECK(plain.stats().pushes == 0);
+}
+
+void SizeSuite()
+{
+    SafeList<int> list;
+    CHECK(list.empty() && list.size() == 0);
+    list.push_back(1);
+    list.push_back(2);
+    CHECK(!list.empty() && list.size() == 2 && list.size_exact() == 2);
+    list.pop_front();
+    CHECK(list.size() == 1);
+}
+
+void LayoutSuite()
+{
+    CHECK(alignof(SafeList<int>) >= SAFELIST_CACHE_LINE);
+    CHECK(sizeof(SafeList<int>) % SAFELIST_CACHE_LINE == 0);
+    SafeList<int> lists[2];
+    CHECK((char*)&lists[1] - (char*)&lists[0] >= (ptrdiff_t)SAFELIST_CACHE_LINE);
+}
+
+void SpscSuite()
+{
+    SpscSafeList<long> queue(16);
+    long sum = 0;
+    thread producer([&]() { for (long i = 1; i <= 100000; ++i) queue.push_back(i); });
+    long expected = 1;
+    bool ordered = true;
+    for (long got = 0; got < 100000; )
+    {
+        long item;
+        if (queue.try_pop(item))
+        {
+            ordered = ordered && item == expected++;
+            sum += item;
+            ++got;
+        }
+        else
+            this_thread::yield();
+    }
+    producer.join();
+    CHECK(ordered && sum == 100000L * 100001 / 2);
+}
+
+void PrioritySuite()
+{
+    SafePriorityList<int> list;
+    int items[] = { 5, 1, 9, 3, 7 };
+    for (int i = 0; i < 5; ++i)
+        list.push_back(items[i]);
+    CHECK(list.pop_front() == 9 && list.pop_front() == 7 && list.pop_front() == 5);
+
+    /* Equal priorities come out in the order they went in. */
+    SafePriorityList<pair<int, int>, function<bool(const pair<int, int>&, const pair<int, int>&)> > fifo(
+        [](const pair<int, int>& a, const pair<int, int>& b) { return a.first < b.first; });
+    for (int i = 0; i < 4; ++i)
+        fifo.push_back(make_pair(1, i));
+    bool ordered = true;
+    for (int i = 0; i < 4; ++i)
+        ordered = ordered && fifo.pop_front().second == i;
+    CHECK(ordered);
+}
+
+void SelectorSuite()
+{
+    typedef SafeListSelector<int> Selector;
+    Selector::List heavy, light;
+    Selector selector;
+    CHECK(selector.add(heavy, 3) == 0 && selector.add(light, 1) == 1);
+
+    int item;
+    size_t index = 99;
+    CHECK(!selector.try_select(item, &index));
+    Clock::time_point start = Clock::now();
+    CHECK(!selector.select_for(item, chrono::milliseconds(30), &index) && ElapsedMs(start) >= 25);
+
+    /* While both are busy, heavy gets three items for every one from light. */
+    for (int i = 0; i < 40; ++i)
+    {
+        heavy.push_back(0);
+        light.push_back(1);
+    }
+    int from[2] = { 0, 0 };
+    for (int i = 0; i < 40; ++i)
+    {
+        CHECK(selector.try_select(item, &index));
+        ++from[index];
+    }
+    CHECK(from[0] == 30 && from[1] == 10);
+
+    /* An empty list never holds up the other. */
+    while (selector.try_select(item))
+        ;
+    light.push_back(2);
+    CHECK(selector.try_select(item, &index) && index == 1 && item == 2);
+
+    thread producer([&]() { this_thread::sleep_for(chrono::milliseconds(20)); heavy.push_back(5); });
+    CHECK(selector.select(item, &index) && item == 5 && index == 0);
+    producer.join();
+}
+
+bool Readable(int fd)
+{
+    struct pollfd entry;
+    entry.fd = fd;
+    entry.events = POLLIN;
+    entry.revents = 0;
+    return poll(&entry, 1, 0) == 1 && (entry.revents & POLLIN);
+}
+
+void FdNotifierSuite()
+{
+    SafeListFdNotifier notifier;
+    CHECK(notifier.valid());
+    SafeList<int, SafeListTraits<AdaptiveMutexLock, SafeListWithNotifier> > list;
+    list.set_notifier(&notifier);
+
+    CHECK(!Readable(notifier.fd()));
+    list.push_back(1);
+    CHECK(Readable(notifier.fd()));
+    list.push_back(2);
+    notifier.clear();
+    CHECK(!Readable(notifier.fd()));
+
+    /* Only the empty to non-empty transition re-arms it. */
+    list.pop_front();
+    list.push_back(3);
+    CHECK(!Readable(notifier.fd()));
+    int item;
+    while (list.try_pop(item))
+        ;
+    list.push_back(4);
+    CHECK(Readable(notifier.fd()));
+
+    list.set_notifier(NULL);
+    notifier.clear();
+    list.pop_front();
+    list.push_back(5);
+    CHECK(!Readable(notifier.fd()));
+}
+
+void ParallelSuite()
+{
+    SafeList<long> list;
+    for (long i = 0; i < 4 * SAFELIST_PARALLEL_MIN_CHUNK; ++i)
+        list.push_back(1);
+
+    vector<thread> threads;
+    ThreadExecutor executor(threads);
+    atomic<long> sum(0);
+    list.parallel_visit(executor, [&](const long& item) { sum += item; return true; }, 4);
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    CHECK(sum == 4 * SAFELIST_PARALLEL_MIN_CHUNK && threads.size() == 3);
+
+    threads.clear();
+    list.parallel_for_each(executor, [](long& item) { item = 2; }, 4);
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+    CHECK(list.contains(2) && !list.contains(1));
+
+    /* An executor that refuses work: the error comes back and the lock is free. */
+    int accepted = 0;
+    bool threw = false;
+    try
+    {
+        list.parallel_visit([&](const function<void()>& part)
+        {
+            if (accepted++)
+                throw runtime_error("executor");
+            part();
+        }, [](const long&) { return true; }, 4);
+    }
+    catch (const runtime_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw);
+    list.push_back(3);
+    CHECK(list.size_exact() == 4 * SAFELIST_PARALLEL_MIN_CHUNK + 1);
+}
+
+void FilterSuite()
+{
+    SafeList<int> queue;
+    for (int i = 0; i < 10; ++i)
+        queue.push_back(i);
+    CHECK(queue.remove_if([](const int& item) { return item % 2 == 0; }) == 5);
+    list<int> odd;
+    CHECK(queue.extract_if([](const int& item) { return item > 4; }, odd) == 3);
+    CHECK(odd.size() == 3 && odd.front() == 5 && queue.size_exact() == 2);
+
+    /* Each NodePoolAllocator has its own pool, so these two don't compare equal. */
+    SafeList<int, AdaptiveMutexLock, NodePoolAllocator<int> > pooled;
+    list<int, NodePoolAllocator<int> > other;
+    for (int i = 0; i < 10; ++i)
+        pooled.push_back(i);
+    CHECK(!(other.get_allocator() == list<int, NodePoolAllocator<int> >().get_allocator()));
+    CHECK(pooled.extract_if([](const int& item) { return item < 3; }, other) == 3);
+    CHECK(other.size() == 3 && other.back() == 2 && pooled.size_exact() == 7);
+
+    /* A throwing predicate still hands over what it had matched. */
+    bool threw = false;
+    try
+    {
+        pooled.extract_if([](const int& item) -> bool { if (item == 6) throw runtime_error("pred"); return item == 4; }, other);
+    }
+    catch (const runtime_error&)
+    {
+        threw = true;
+    }
+    CHECK(threw && other.size() == 4 && other.back() == 4 && pooled.size_exact() == 6);
+}
+
+/* The list a DestroyProbe pokes from its destructor; see DeferredSuite(). */
+struct DestroyProbe;
+SafeList<DestroyProbe>* probed = NULL;
+
+struct DestroyProbe
+{
+    DestroyProbe() : armed(false) {}
+    ~DestroyProbe()
+    {
+        /* Deadlocks if the list destroys us with its lock held. */
+        if (armed && probed)
+            probed->size_exact();
+    }
+    bool operator==(const DestroyProbe& other) const { return armed == other.armed; }
+
+    bool armed;
+};
+
+void DeferredSuite()
+{
+    SafeList<DestroyProbe> list;
+    probed = &list;
+    DestroyProbe probe;
+    probe.armed = true;
+    for (int i = 0; i < 3; ++i)
+        list.push_back(probe);
+    DestroyProbe out;
+    CHECK(list.try_pop(out) && out.armed);
+    list.remove(probe);
+    CHECK(list.size_exact() == 0);
+    out.armed = false;
+    probe.armed = false;
+    probed = NULL;
+}
+
+void WorkStealingSuite()
+{
+    WorkStealingList<long> queue(4);
+    for (long i = 1; i <= 1000; ++i)
+        queue.inject(i);
+    atomic<long> sum(0);
+    atomic<long> taken(0);
+    vector<thread> workers;
+    for (size_t w = 0; w < 4; ++w)
+        workers.push_back(thread([&, w]()
+        {
+            long item;
+            while (taken.load() < 1000)
+            {
+                if (queue.try_pop(w, item))
+                {
+                    sum += item;
+                    ++taken;
+                }
+                else
+                    this_thread::yield();
+            }
+        }));
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i].join();
+    CHECK(sum == 1000L * 1001 / 2 && queue.empty());
+
+    WorkStealingDeque<int> deque;
+    for (int i = 0; i < 3; ++i)
+        deque.push_back(i);
+    int item;
+    CHECK(deque.try_steal(item) && item == 0);
+    CHECK(deque.try_pop(item) && item == 2);
+}
+
+void SharedLockSuite()
+{
+    /* Two visit_all() calls run at once only if the lock is taken shared. */
+    SafeList<int, SharedMutexLock> list;
+    list.push_back(1);
+    atomic<int> inside(0);
+    atomic<bool> overlapped(false);
+    auto visit = [&]()
+    {
+        list.visit_all([&](const int&)
+        {
+            ++inside;
+            Clock::time_point start = Clock::now();
+            while (ElapsedMs(start) < 2000 && inside.load() < 2)
+                this_thread::yield();
+            if (inside.load() == 2)
+                overlapped = true;
+            return true;
+        });
+    };
+    thread first(visit), second(visit);
+    first.join();
+    second.join();
+    CHECK(overlapped);
+}
+
+void MappedSuite()
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/safelist_test_%d.queue", (int)getpid());
+    unlink(path);
+    {
+        MappedSafeList<Pod> queue(path, 8);
+        CHECK(queue.valid() && queue.capacity() == 8);
+        for (int i = 0; i < 5; ++i)
+        {
+            Pod pod = { i, i * 0.5f };
+            queue.push_back(pod);
+        }
+        Pod pod;
+        CHECK(queue.try_pop(pod) && pod.id == 0);
+        MappedSafeList<Pod> second(path, 8);
+        CHECK(!second.valid());
+    }
+
+    /* Reopening picks up where it was left, whatever capacity is asked for. */
+    {
+        MappedSafeList<Pod> queue(path, 100);
+        CHECK(queue.valid() && queue.capacity() == 8 && queue.size() == 4);
+        Pod pod;
+        CHECK(queue.try_pop(pod) && pod.id == 1 && pod.weight == 0.5f);
+    }
+    {
+        MappedSafeList<int> wrong_type(path, 8);
+        CHECK(!wrong_type.valid());
+    }
+
+    /* A header that doesn't fit the file is refused, not trusted. */
+    const off_t capacity_offset = 24, tail_offset = 40;
+    int fd = open(path, O_RDWR);
+    uint64_t bogus = 1ULL << 62;
+    CHECK(pwrite(fd, &bogus, sizeof(bogus), capacity_offset) == (ssize_t)sizeof(bogus));
+    {
+        MappedSafeList<Pod> queue(path, 8);
+        CHECK(!queue.valid());
+    }
+    uint64_t capacity = 8, tail = 1000;
+    CHECK(pwrite(fd, &capacity, sizeof(capacity), capacity_offset) == (ssize_t)sizeof(capacity));
+    CHECK(pwrite(fd, &tail, sizeof(tail), tail_offset) == (ssize_t)sizeof(tail));
+    {
+        MappedSafeList<Pod> queue(path, 8);
+        CHECK(!queue.valid());
+    }
+    tail = 5;
+    CHECK(pwrite(fd, &tail, sizeof(tail), tail_offset) == (ssize_t)sizeof(tail));
+    {
+        MappedSafeList<Pod> queue(path, 8);
+        CHECK(queue.valid() && queue.size() == 3);
+    }
+    CHECK(ftruncate(fd, 100) == 0);
+    {
+        MappedSafeList<Pod> queue(path, 8);
+        CHECK(!queue.valid());
+    }
+    close(fd);
+    unlink(path);
+}
+
+void SharedMemorySuite()
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/safelist_test_%d", (int)getpid());
+    SharedMemorySafeList<long>::unlink(name);
+    {
+        SharedMemorySafeList<long> queue(name, 16);
+        CHECK(queue.valid() && queue.capacity() == 16);
+
+        pid_t child = fork();
+        if (child == 0)
+        {
+            SharedMemorySafeList<long> other(name, 0);
+            for (long i = 1; i <= 100; ++i)
+                other.push_back(i);
+            _exit(other.valid() ? 0 : 1);
+        }
+        long sum = 0;
+        for (int i = 0; i < 100; ++i)
+            sum += queue.wait_pop();
+        int status = 0;
+        waitpid(child, &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0 && sum == 100L * 101 / 2);
+
+        /* A process that dies holding the lock doesn't wedge the others. */
+        queue.push_back(42);
+        child = fork();
+        if (child == 0)
+        {
+            SharedMemorySafeList<long> other(name, 0);
+            other.visit_all([](const long&) -> bool { _exit(0); });
+            _exit(1);
+        }
+        waitpid(child, &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        queue.push_back(43);
+        long item = 0;
+        CHECK(queue.try_pop(item) && item == 42);
+        CHECK(queue.try_pop(item) && item == 43 && queue.empty());
+
+        Clock::time_point start = Clock::now();
+        CHECK(queue.wait_pop_for(chrono::milliseconds(30)) == 0 && ElapsedMs(start) >= 25);
+    }
+    CHECK(SharedMemorySafeList<long>::unlink(name));
+}
+
+void StreamSuite()
+{
+    SafeList<Pod> list;
+    for (int i = 0; i < 1000; ++i)
+    {
+        Pod pod = { i, i * 0.25f };
+        list.push_back(pod);
+    }
+    string stream;
+    CHECK(list.write_to([&](const struct iovec* iov, int count)
+    {
+        for (int i = 0; i < count; ++i)
+            stream.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        return true;
+    }, 512));
+    CHECK(stream.size() == sizeof(SafeListStreamHeader) + 1000 * sizeof(Pod));
+
+    /* Reads back from a string, optionally after damaging a copy of it. */
+    struct Reader
+    {
+        Reader(const string& data_arg) : data(data_arg), offset(0) {}
+        size_t operator()(void* buffer, size_t bytes)
+        {
+            size_t count = min(bytes, data.size() - offset);
+            memcpy(buffer, data.data() + offset, count);
+            offset += count;
+            return count;
+        }
+        string data;
+        size_t offset;
+    };
+
+    SafeList<Pod> copy;
+    Reader whole(stream);
+    CHECK(copy.load_from(whole) && copy.size_exact() == 1000);
+    Pod pod;
+    CHECK(copy.try_pop(pod) && pod.id == 0 && pod.weight == 0.0f);
+
+    SafeList<Pod> target;
+    Reader truncated(stream.substr(0, stream.size() - 1));
+    CHECK(!target.load_from(truncated) && target.size_exact() == 0);
+    Reader header_only(stream.substr(0, sizeof(SafeListStreamHeader) - 4));
+    CHECK(!target.load_from(header_only));
+
+    string bad_magic = stream;
+    bad_magic[0] ^= 0xff;
+    Reader corrupt(bad_magic);
+    CHECK(!target.load_from(corrupt));
+
+    /* A huge count is caught by the first short read, not by allocating for it. */
+    string hostile = stream.substr(0, sizeof(SafeListStreamHeader) + 10 * sizeof(Pod));
+    SafeListStreamHeader header;
+    memcpy(&header, hostile.data(), sizeof(header));
+    header.count = 1ULL << 40;
+    memcpy(&hostile[0], &header, sizeof(header));
+    Reader lying(hostile);
+    CHECK(!target.load_from(lying) && target.size_exact() == 0);
+
+    SafeList<int> wrong_type;
+    Reader mismatched(stream);
+    CHECK(!wrong_type.load_from(mismatched));
+}
+
+void NumaSuite()
+{
+    NumaSafeList<int> list;
+    CHECK(list.node_count() >= 1);
+    list.reserve(64);
+    for (int i = 0; i < 100; ++i)
+        list.push_back(i);
+    CHECK(list.size() == 100);
+    long sum = 0;
+    int item;
+    while (list.try_pop(item))
+        sum += item;
+    CHECK(sum == 99L * 100 / 2 && list.empty());
+}
+
+/* Counts the hook calls the lists using it make. */
+size_t hook_links = 0;
+size_t hook_unlinks = 0;
+
+struct CountingHooks
+{
+    void trace(const char*) const {}
+    void trace(const char*, size_t) const {}
+    void linked(size_t count) const { hook_links += count; }
+    template<class Iterator>
+    void unlinking(Iterator first, Iterator last) const { hook_unlinks += distance(first, last); }
+};
+
+void TraitsSuite()
+{
+    typedef SafeListTraits<TicketSpinLock, SafeListWithEverything, SafeListNoHooks, NodePoolAllocator> Everything;
+    SafeList<int, Everything> full(4);
+    CHECK(full.try_push(1));
+    SafeListHandle handle = full.push_back_handle(2);
+    CHECK(full.erase(handle) && full.wait_pop_for(chrono::milliseconds(1)) == 1);
+
+    /* Disabled features and stateless hooks cost no space: the list, the lock and the size, a line each. */
+    typedef SafeList<int, SafeListTraits<AdaptiveMutexLock, 0> > Lean;
+    CHECK(sizeof(Lean) <= 3 * SAFELIST_CACHE_LINE);
+    CHECK(sizeof(Lean) == sizeof(SafeList<int, SafeListTraits<AdaptiveMutexLock, 0, CountingHooks> >));
+    CHECK(sizeof(Lean) < sizeof(SafeList<int, SafeListTraits<AdaptiveMutexLock, SafeListWithEverything> >));
+
+    SafeList<int, SafeListTraits<AdaptiveMutexLock, 0, CountingHooks> > counted;
+    counted.push_back(1);
+    counted.push_back(2);
+    counted.pop_front();
+    CHECK(hook_links == 2 && hook_unlinks == 1);
+}
+
+struct Suite
+{
+    const char* name;
+    void (*run)();
+};
+
+const Suite suites[] =
+{
+    { "blocking", BlockingSuite },
+    { "lockfree", LockFreeSuite },
+    { "batch", BatchSuite },
+    { "lock_policy", LockPolicySuite },
+    { "move", MoveSuite },
+    { "pool", PoolSuite },
+    { "sharded", ShardedSuite },
+    { "snapshot", SnapshotSuite },
+    { "visitor", VisitorSuite },
+    { "handle", HandleSuite },
+    { "ring", RingSuite },
+    { "bounded", BoundedSuite },
+    { "stats", StatsSuite },
+    { "size", SizeSuite },
+    { "layout", LayoutSuite },
+    { "spsc", SpscSuite },
+    { "priority", PrioritySuite },
+    { "selector", SelectorSuite },
+    { "fd_notifier", FdNotifierSuite },
+    { "parallel", ParallelSuite },
+    { "filter", FilterSuite },
+    { "deferred", DeferredSuite },
+    { "work_stealing", WorkStealingSuite },
+    { "shared_lock", SharedLockSuite },
+    { "mapped", MappedSuite },
+    { "stream", StreamSuite },
+    { "shared_memory", SharedMemorySuite },
+    { "numa", NumaSuite },
+    { "traits", TraitsSuite },
+};
+
+bool ParseArgs(int argc, char** argv)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+            filter = argv[++i];
+        else
+        {
+            fprintf(stderr, "usage: %s [--filter text]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    if (!ParseArgs(argc, argv))
+        return 2;
+
+    for (size_t i = 0; i < sizeof(suites) / sizeof(suites[0]); ++i)
+    {
+        if (!filter.empty() && string(suites[i].name).find(filter) == string::npos)
+            continue;
+        suite_failures = 0;
+        suites[i].run();
+        if (suite_failures)
+            printf("%-16s FAILED\n", suites[i].name);
+        else
+            printf("%-16s ok\n", suites[i].name);
+        fflush(stdout);
+        failures += suite_failures;
+    }
+    return failures ? 1 : 0;
+}
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/
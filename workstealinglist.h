@@ -0,0 +1,424 @@
+/***************************************************************************
+                          workstealinglist.h  -  description
+                             -------------------
+    begin                : Wed Oct 14 2026
+    copyright            : (C) 2026 by Bob Burrough
+    email                : xxx
+ ***************************************************************************/
+
+
+#ifndef WORKSTEALINGLIST_H
+#define WORKSTEALINGLIST_H
+
+#include "safelist.h"
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/* How many items a worker moves from the injection queue to its own deque at once. */
+#ifndef SAFELIST_INJECT_BATCH
+#define SAFELIST_INJECT_BATCH 32
+#endif
+
+using namespace std;
+
+/*
+    WorkStealingDeque
+
+    Chase-Lev deque, in the C11 formulation by Le, Pop, Cohen and Zappa
+    Nardelli. The owning thread pushes and pops at the bottom (LIFO, so it
+    keeps working on what it spawned most recently, which is still in its
+    cache), without locks and, unless the deque is nearly empty, without
+    any atomic read-modify-write. Any other thread may steal from the top
+    (FIFO), racing with the others through one CAS.
+
+    The ring grows when the owner fills it. Outgrown rings are kept until
+    the deque is destroyed, since a thief may still be reading from one.
+    Slots are read racily by thieves before they know they have won, so T
+    has to be trivially copyable; in practice it is a pointer or a handle.
+*/
+template <class T>
+class alignas(SAFELIST_CACHE_LINE) WorkStealingDeque
+{
+    static_assert(is_trivially_copyable<T>::value, "WorkStealingDeque needs a trivially copyable T, such as a pointer");
+
+public:
+
+    explicit WorkStealingDeque(size_t initial_capacity = 256);
+    virtual ~WorkStealingDeque();
+
+
+    /* Owner thread only. */
+    void push_back(const T& arg);
+    bool try_pop(T& out);
+
+    /*
+        Any thread. Returns false if the deque was empty or another thread
+        took the top item first; lost is set in the latter case, which means
+        it is worth trying again.
+    */
+    bool try_steal(T& out, bool* lost = NULL);
+
+    /* A snapshot, exact only when no thread is using the deque. */
+    size_t size() const;
+    bool empty() const;
+
+private:
+    WorkStealingDeque(const WorkStealingDeque&);
+    WorkStealingDeque& operator=(const WorkStealingDeque&);
+
+    struct Ring
+    {
+        explicit Ring(long long capacity) : mask(capacity - 1), slots(new atomic<T>[capacity]) {}
+        ~Ring() { delete[] slots; }
+
+        T get(long long index) const
+        {
+            return slots[index & mask].load(memory_order_relaxed);
+        }
+        void put(long long index, const T& arg)
+        {
+            slots[index & mask].store(arg, memory_order_relaxed);
+        }
+
+        long long mask;
+        atomic<T>* slots;
+    };
+
+    Ring* Grow(Ring* ring, long long bottom_index, long long top_index);
+
+    /* Written by thieves (and by the owner when it takes the last item). */
+    alignas(SAFELIST_CACHE_LINE) atomic<long long> top;
+
+    /* Written by the owner only. */
+    alignas(SAFELIST_CACHE_LINE) atomic<long long> bottom;
+    atomic<Ring*> ring;
+    vector<Ring*> retired;
+};
+
+template<class T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t initial_capacity)
+    : top(0), bottom(0), ring(NULL)
+{
+    long long capacity = 2;
+    while (capacity < static_cast<long long>(initial_capacity))
+        capacity <<= 1;
+    ring.store(new Ring(capacity), memory_order_relaxed);
+}
+
+template<class T>
+WorkStealingDeque<T>::~WorkStealingDeque()
+{
+    delete ring.load(memory_order_relaxed);
+    for (size_t i = 0; i < retired.size(); ++i)
+        delete retired[i];
+}
+
+template<class T>
+typename WorkStealingDeque<T>::Ring* WorkStealingDeque<T>::Grow(Ring* old_ring, long long bottom_index, long long top_index)
+{
+    Ring* grown = new Ring((old_ring->mask + 1) * 2);
+    for (long long i = top_index; i < bottom_index; ++i)
+        grown->put(i, old_ring->get(i));
+    retired.push_back(old_ring);
+    ring.store(grown, memory_order_release);
+    return grown;
+}
+
+template<class T>
+void WorkStealingDeque<T>::push_back(const T& arg)
+{
+    long long b = bottom.load(memory_order_relaxed);
+    long long t = top.load(memory_order_acquire);
+    Ring* r = ring.load(memory_order_relaxed);
+    if (b - t > r->mask)
+        r = Grow(r, b, t);
+    r->put(b, arg);
+    atomic_thread_fence(memory_order_release);
+    bottom.store(b + 1, memory_order_relaxed);
+}
+
+template<class T>
+bool WorkStealingDeque<T>::try_pop(T& out)
+{
+    long long b = bottom.load(memory_order_relaxed) - 1;
+    Ring* r = ring.load(memory_order_relaxed);
+    bottom.store(b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = top.load(memory_order_relaxed);
+
+    if (t > b)
+    {
+        bottom.store(b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    T item = r->get(b);
+    if (t == b)
+    {
+        /* Last item: race the thieves for it. */
+        bool won = top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+        bottom.store(b + 1, memory_order_relaxed);
+        if (!won)
+            return false;
+    }
+    out = item;
+    return true;
+}
+
+template<class T>
+bool WorkStealingDeque<T>::try_steal(T& out, bool* lost)
+{
+    if (lost)
+        *lost = false;
+    long long t = top.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = bottom.load(memory_order_acquire);
+    if (t >= b)
+        return false;
+
+    Ring* r = ring.load(memory_order_acquire);
+    T item = r->get(t);
+    if (!top.compare_exchange_strong(t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+        if (lost)
+            *lost = true;
+        return false;
+    }
+    out = item;
+    return true;
+}
+
+template<class T>
+size_t WorkStealingDeque<T>::size() const
+{
+    long long b = bottom.load(memory_order_relaxed);
+    long long t = top.load(memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+}
+
+template<class T>
+bool WorkStealingDeque<T>::empty() const
+{
+    return size() == 0;
+}
+
+/*
+    WorkStealingList
+
+    Run queue for a fixed pool of workers, numbered 0 to worker_count - 1.
+    Each worker owns a WorkStealingDeque, and there is one shared SafeList
+    for work that comes from outside the pool.
+
+    push_back(worker, item) puts work a worker spawned on its own deque;
+    only worker itself may call it. inject() is for every other thread and
+    goes to the shared list. try_pop(worker, out), again only from worker
+    itself, takes the newest item from the worker's own deque, then moves
+    up to SAFELIST_INJECT_BATCH items from the shared list onto the deque
+    (one lock round trip for the lot), then steals the oldest item from the
+    other workers in turn. Workers therefore only meet on the shared list
+    when they have run dry, instead of on every pop.
+
+    As with WorkStealingDeque, T has to be trivially copyable.
+*/
+template <class T, class LockPolicy = AdaptiveMutexLock>
+class WorkStealingList
+{
+public:
+
+    /* worker_count of 0 means one worker per hardware thread. */
+    explicit WorkStealingList(size_t worker_count = 0, size_t initial_capacity = 256);
+    virtual ~WorkStealingList();
+
+
+    size_t worker_count() const;
+    bool empty() const;
+    size_t size() const;
+
+    /* Owner side: worker must be the calling worker's own number. */
+    void push_back(size_t worker, const T& arg);
+    bool try_pop(size_t worker, T& out);
+    T pop_front(size_t worker);
+
+    /* Any thread. */
+    void inject(const T& arg);
+    template<class InputIt>
+    void inject(InputIt first, InputIt last);
+
+private:
+    WorkStealingList(const WorkStealingList&);
+    WorkStealingList& operator=(const WorkStealingList&);
+
+    typedef WorkStealingDeque<T> Deque;
+
+    bool Refill(size_t worker, T& out);
+    bool Steal(size_t worker, T& out);
+
+    /* Placed by hand, like ShardedSafeList's shards, so each deque starts on its own cache line. */
+    void* deque_storage;
+    Deque* deques;
+    size_t deques_size;
+
+    SafeList<T, LockPolicy> injection;
+};
+
+template<class T, class LockPolicy>
+WorkStealingList<T, LockPolicy>::WorkStealingList(size_t worker_count, size_t initial_capacity)
+{
+    if (worker_count == 0)
+        worker_count = thread::hardware_concurrency();
+    if (worker_count == 0)
+        worker_count = 1;
+    deques_size = worker_count;
+
+    deque_storage = ::operator new(deques_size * sizeof(Deque) + SAFELIST_CACHE_LINE);
+    size_t misalignment = reinterpret_cast<uintptr_t>(deque_storage) % SAFELIST_CACHE_LINE;
+    deques = reinterpret_cast<Deque*>(static_cast<char*>(deque_storage) +
+                                      (misalignment ? SAFELIST_CACHE_LINE - misalignment : 0));
+    for (size_t i = 0; i < deques_size; ++i)
+        new (&deques[i]) Deque(initial_capacity);
+}
+
+template<class T, class LockPolicy>
+WorkStealingList<T, LockPolicy>::~WorkStealingList()
+{
+    for (size_t i = 0; i < deques_size; ++i)
+        deques[i].~Deque();
+    ::operator delete(deque_storage);
+}
+
+template<class T, class LockPolicy>
+size_t WorkStealingList<T, LockPolicy>::worker_count() const
+{
+    return deques_size;
+}
+
+template<class T, class LockPolicy>
+void WorkStealingList<T, LockPolicy>::push_back(size_t worker, const T& arg)
+{
+    deques[worker].push_back(arg);
+}
+
+template<class T, class LockPolicy>
+void WorkStealingList<T, LockPolicy>::inject(const T& arg)
+{
+    injection.push_back(arg);
+}
+
+template<class T, class LockPolicy>
+template<class InputIt>
+void WorkStealingList<T, LockPolicy>::inject(InputIt first, InputIt last)
+{
+    injection.push_back(first, last);
+}
+
+/*
+    Pops a batch off the injection queue, keeps the oldest for the caller and
+    pushes the rest onto the worker's deque newest first, so the worker's
+    LIFO pops still hand them out oldest first.
+*/
+template<class T, class LockPolicy>
+bool WorkStealingList<T, LockPolicy>::Refill(size_t worker, T& out)
+{
+    if (injection.empty())
+        return false;
+    T batch[SAFELIST_INJECT_BATCH];
+    size_t count = injection.pop_front_n(batch, SAFELIST_INJECT_BATCH);
+    if (count == 0)
+        return false;
+    for (size_t i = count - 1; i > 0; --i)
+        deques[worker].push_back(batch[i]);
+    out = batch[0];
+    return true;
+}
+
+template<class T, class LockPolicy>
+bool WorkStealingList<T, LockPolicy>::Steal(size_t worker, T& out)
+{
+    for (size_t i = 1; i < deques_size; ++i)
+    {
+        Deque& victim = deques[(worker + i) % deques_size];
+        bool lost = true;
+        while (lost)
+        {
+            if (victim.try_steal(out, &lost))
+                return true;
+        }
+    }
+    return false;
+}
+
+template<class T, class LockPolicy>
+bool WorkStealingList<T, LockPolicy>::try_pop(size_t worker, T& out)
+{
+    return deques[worker].try_pop(out) || Refill(worker, out) || Steal(worker, out);
+}
+
+template<class T, class LockPolicy>
+T WorkStealingList<T, LockPolicy>::pop_front(size_t worker)
+{
+    T ret_val = T();
+    try_pop(worker, ret_val);
+    return ret_val;
+}
+
+template<class T, class LockPolicy>
+size_t WorkStealingList<T, LockPolicy>::size() const
+{
+    size_t total = injection.size();
+    for (size_t i = 0; i < deques_size; ++i)
+        total += deques[i].size();
+    return total;
+}
+
+template<class T, class LockPolicy>
+bool WorkStealingList<T, LockPolicy>::empty() const
+{
+    return size() == 0;
+}
+
+#endif
+
+/*
+------------------------------------------------------------------------------
+This software is available under 2 licenses -- choose whichever you prefer.
+------------------------------------------------------------------------------
+ALTERNATIVE A - MIT License
+Copyright (c) 2003-2019 Bobby G. Burrough
+Permission is hereby granted, free of charge, to any person obtaining a copy of 
+this software and associated documentation files (the "Software"), to deal in 
+the Software without restriction, including without limitation the rights to 
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies 
+of the Software, and to permit persons to whom the Software is furnished to do 
+so, subject to the following conditions:
+The above copyright notice and this permission notice shall be included in all 
+copies or substantial portions of the Software.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE 
+SOFTWARE.
+------------------------------------------------------------------------------
+ALTERNATIVE B - Public Domain (www.unlicense.org)
+This is free and unencumbered software released into the public domain.
+Anyone is free to copy, modify, publish, use, compile, sell, or distribute this 
+software, either in source code form or as a compiled binary, for any purpose, 
+commercial or non-commercial, and by any means.
+In jurisdictions that recognize copyright laws, the author or authors of this 
+software dedicate any and all copyright interest in the software to the public 
+domain. We make this dedication for the benefit of the public at large and to 
+the detriment of our heirs and successors. We intend this dedication to be an 
+overt act of relinquishment in perpetuity of all present and future rights to 
+this software under copyright law.
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN 
+ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION 
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+------------------------------------------------------------------------------
+*/